@@ -4,10 +4,15 @@
 #include <vector>
 #include <iomanip>
 #include <algorithm>
+#include <stdexcept>
 
 #include "src/MemoryAllocator.h"
 #include "src/BuddyAllocator.h"
+#include "src/TLSFAllocator.h"
+#include "src/SlabAllocator.h"
+#include "src/ConcurrentAllocator.h"
 #include "src/Cache.h"
+#include "src/MultiCore.h"
 #include "src/VirtualMemory.h"
 
 std::vector<std::string> tokenize(const std::string& command) {
@@ -18,19 +23,47 @@ std::vector<std::string> tokenize(const std::string& command) {
     return tokens;
 }
 
+// "L2" -> 2 when 1 <= 2 <= max_level, else 0.
+int parse_cache_level(std::string token, size_t max_level) {
+    std::transform(token.begin(), token.end(), token.begin(), ::toupper);
+    if (token.size() < 2 || token[0] != 'L' || token.find_first_not_of("0123456789", 1) != std::string::npos) return 0;
+    size_t n = std::stoul(token.substr(1));
+    return (n >= 1 && n <= max_level) ? static_cast<int>(n) : 0;
+}
+
+// "4096" or "2^48" -> value; false on anything else or overflow.
+bool parse_size(const std::string& token, u64& out) {
+    size_t caret = token.find('^');
+    std::string base = token.substr(0, caret);
+    if (base.empty() || base.find_first_not_of("0123456789") != std::string::npos || base.size() > 19) return false;
+    out = std::stoull(base);
+    if (caret == std::string::npos) return true;
+    std::string exp = token.substr(caret + 1);
+    if (exp.empty() || exp.find_first_not_of("0123456789") != std::string::npos || exp.size() > 2) return false;
+    u64 b = out;
+    out = 1;
+    for (int e = std::stoi(exp); e > 0; e--) {
+        if (b && out > UINT64_MAX / b) return false;
+        out *= b;
+    }
+    return true;
+}
+
 int main() {
     MemoryAllocator linear_alloc;
     BuddyAllocator buddy_alloc;
+    TLSFAllocator tlsf_alloc;
+    SlabAllocator slab_alloc;   // carves slabs from a private buddy arena
     Allocator* current_allocator = &linear_alloc;
     Alloc_Algo current_strategy = Firstfit;
 
-    CacheLevel l1(1, 64, 8, 1, LRU);    
-    CacheLevel l2(2, 256, 16, 2, LRU);  
-    CacheLevel l3(3, 512, 32, 4, LRU);  
-    MemoryHierarchy cache_system(&l1, &l2, &l3);
+    // Default hierarchy; reshape it with 'set cache'.
+    MemoryHierarchy cache_system({{64, 8, 1}, {256, 16, 2}, {512, 32, 4}}, LRU, INCLUSIVE);
+    std::unique_ptr<MultiCoreSystem> multicore;   // built by 'init cores'; traces use physical addresses
 
    VirtualMemory mmu(&cache_system, VM_LRU);
-    TLB tlb(16, 4); 
+    TLB tlb;   // 16-entry 4-way L1, 64-entry 4-way STLB
+    std::unique_ptr<SwapDevice> swap;   // built by 'init swap'
 
     std::string line;
     bool is_initialized = false;
@@ -40,11 +73,25 @@ int main() {
     std::cout << "   Memory Management Simulator CLI Started\n";
     std::cout << "   Commands:\n";
     std::cout << "   - init memory <size>\n";
-    std::cout << "   - set cache_policy <LRU|FIFO|LFU>\n";
+    std::cout << "   - set cache_policy <LRU|FIFO|LFU|PLRU|SRRIP|BRRIP|DIP>\n";
     std::cout << "   - set page_policy <LRU|FIFO|CLOCK>\n";
-    std::cout << "   - set allocator <buddy|first_fit|best_fit|worst_fit>\n";
+    std::cout << "   - set allocator <buddy|tlsf|slab|first_fit|best_fit|worst_fit>\n";
+    std::cout << "   - set cache <Ln> size=<bytes> assoc=<ways> block=<bytes> | set cache <Ln> off\n";
+    std::cout << "   - set cache inclusion <inclusive|exclusive|nine>\n";
+    std::cout << "   - set cache classify <on|off>\n";
+    std::cout << "   - set prefetch <Ln> <none|next_line|stride|stream> [degree]\n";
     std::cout << "   - malloc <size> | free <id> | stats\n";
+    std::cout << "   - malloc_batch <count> <size> | free_range <id1> <id2>\n";
+    std::cout << "   - malloc_aligned <size> <align> | realloc <id> <new_size>\n";
+    std::cout << "   - compact [byte_budget]\n";
+    std::cout << "   - init vm [page=<bytes>] [virt=<bytes|2^n>] [phys=<bytes|2^n>]\n";
+    std::cout << "   - set tlb <L1|L2> entries=<n> assoc=<ways> | set tlb L2 off\n";
+    std::cout << "   - hugepage <v_addr> <size>\n";
+    std::cout << "   - fork <pid> | switch <pid>\n";
+    std::cout << "   - init swap [size=<bytes|2^n>] [latency=<us>] [bandwidth=<MB/s>] [readahead=<pages>] [queue=<n>] [gap=<ns>] [file=<path>] | init swap off\n";
     std::cout << "   - read <v_addr> | write <v_addr>\n";
+    std::cout << "   - init cores <n> [host_threads] | core <id> <read|write> <p_addr> | sync | stats cores\n";
+    std::cout << "   - bench <max_threads> [ops_per_thread]\n";
     std::cout << "   - dump memory | exit\n";
     std::cout << "====================================================\n";
 
@@ -63,7 +110,9 @@ int main() {
             try {
                 system_memory_size = std::stoul(tokens[2]);
                 linear_alloc.init(system_memory_size);
+                slab_alloc.init(system_memory_size);
                 buddy_alloc.init(system_memory_size);
+                tlsf_alloc.init(system_memory_size);
                 is_initialized = true;
                 std::cout << "Physical memory initialized to " << system_memory_size << " bytes.\n";
             } catch (...) {
@@ -85,15 +134,17 @@ int main() {
             if (policy_str == "LRU") new_policy = LRU;
             else if (policy_str == "FIFO") new_policy = FIFO;
             else if (policy_str == "LFU") new_policy = LFU;
+            else if (policy_str == "PLRU") new_policy = PLRU;
+            else if (policy_str == "SRRIP") new_policy = SRRIP;
+            else if (policy_str == "BRRIP") new_policy = BRRIP;
+            else if (policy_str == "DIP") new_policy = DIP;
             else {
-                std::cout << "Error: Unknown cache policy '" << policy_str << "'. Use LRU, FIFO, or LFU.\n";
+                std::cout << "Error: Unknown cache policy '" << policy_str << "'. Use LRU, FIFO, LFU, PLRU, SRRIP, BRRIP, or DIP.\n";
                 valid = false;
             }
 
             if (valid) {
-                l1.set_policy(new_policy);
-                l2.set_policy(new_policy);
-                l3.set_policy(new_policy);
+                cache_system.set_policy(new_policy);
                 std::cout << "Cache replacement policy set to " << policy_str << " for all levels.\n";
             }
         }
@@ -116,11 +167,122 @@ int main() {
             }
         }
 
+        else if (cmd == "set" && tokens.size() >= 4 && tokens[1] == "prefetch") {
+            std::string lvl = tokens[2];
+            std::string kind = tokens[3];
+            std::transform(lvl.begin(), lvl.end(), lvl.begin(), ::toupper);
+            std::transform(kind.begin(), kind.end(), kind.begin(), ::tolower);
+            int level_id = parse_cache_level(lvl, cache_system.depth());
+            int degree = kind == "stream" ? 4 : kind == "stride" ? 2 : 1;
+            if (tokens.size() >= 5) {
+                try {
+                    degree = std::stoi(tokens[4]);
+                } catch (...) {
+                    std::cout << "Error: Usage: set prefetch <Ln> <none|next_line|stride|stream> [degree].\n";
+                    continue;
+                }
+            }
+
+            if (level_id == 0) {
+                std::cout << "Error: Unknown cache level '" << tokens[2] << "'. Hierarchy has L1-L" << cache_system.depth() << ".\n";
+            } else if (kind == "none") {
+                cache_system.set_prefetcher(level_id, nullptr);
+                std::cout << "Prefetching disabled for " << lvl << ".\n";
+            } else {
+                u64 bs = cache_system.block_size(level_id);
+                std::unique_ptr<Prefetcher> pf;
+                if (kind == "next_line") pf = std::make_unique<NextLinePrefetcher>(bs, degree);
+                else if (kind == "stride") pf = std::make_unique<StridePrefetcher>(bs, degree);
+                else if (kind == "stream") pf = std::make_unique<StreamPrefetcher>(bs, degree);
+
+                if (pf) {
+                    std::cout << "Prefetcher for " << lvl << " set to " << kind << " (degree " << pf->get_degree() << ").\n";
+                    cache_system.set_prefetcher(level_id, std::move(pf));
+                } else {
+                    std::cout << "Error: Unknown prefetcher '" << tokens[3] << "'. Use none, next_line, stride, or stream.\n";
+                }
+            }
+        }
+
+        else if (cmd == "set" && tokens.size() >= 4 && tokens[1] == "cache" && tokens[2] == "classify") {
+            if (tokens[3] == "on" || tokens[3] == "off") {
+                cache_system.set_miss_classification(tokens[3] == "on");
+                std::cout << "Miss classification " << (tokens[3] == "on" ? "enabled" : "disabled") << " for all levels.\n";
+            } else {
+                std::cout << "Error: Usage: set cache classify <on|off>.\n";
+            }
+        }
+
+        else if (cmd == "set" && tokens.size() >= 4 && tokens[1] == "cache" && tokens[2] == "inclusion") {
+            std::string mode = tokens[3];
+            std::transform(mode.begin(), mode.end(), mode.begin(), ::toupper);
+            if (mode == "INCLUSIVE") cache_system.set_inclusion(INCLUSIVE);
+            else if (mode == "EXCLUSIVE") cache_system.set_inclusion(EXCLUSIVE);
+            else if (mode == "NINE") cache_system.set_inclusion(NINE);
+            else {
+                std::cout << "Error: Unknown inclusion policy '" << tokens[3] << "'. Use inclusive, exclusive, or nine.\n";
+                continue;
+            }
+            std::cout << "Cache inclusion set to " << mode << " (caches flushed).\n";
+        }
+
+        else if (cmd == "set" && tokens.size() >= 4 && tokens[1] == "cache") {
+            size_t depth = cache_system.depth();
+            int level_id = parse_cache_level(tokens[2], depth + 1);
+            if (level_id == 0) {
+                std::cout << "Error: Unknown cache level '" << tokens[2] << "'. Configure L1-L" << depth + 1 << ".\n";
+                continue;
+            }
+            if (tokens[3] == "off") {
+                if (level_id == 1 || static_cast<size_t>(level_id) > depth) {
+                    std::cout << "Error: Can only remove existing levels below L1.\n";
+                } else {
+                    cache_system.truncate(level_id - 1);
+                    std::cout << "Cache levels from L" << level_id << " down removed (" << cache_system.depth() << " levels left).\n";
+                }
+                continue;
+            }
+
+            // Unspecified fields keep the level's current value; a new level
+            // starts from the one above it.
+            bool is_new = static_cast<size_t>(level_id) > depth;
+            CacheLevelSpec spec = cache_system.spec(is_new ? level_id - 1 : level_id);
+            bool has_size = false, ok = true;
+            for (size_t i = 3; i < tokens.size(); i++) {
+                size_t eq = tokens[i].find('=');
+                std::string key = tokens[i].substr(0, eq);
+                if (eq == std::string::npos || tokens[i].find_first_not_of("0123456789", eq + 1) != std::string::npos || eq + 1 == tokens[i].size()) { ok = false; break; }
+                u64 val = std::stoull(tokens[i].substr(eq + 1));
+                if (key == "size") { spec.size = val; has_size = true; }
+                else if (key == "assoc") spec.associativity = static_cast<int>(val);
+                else if (key == "block") spec.block_size = val;
+                else { ok = false; break; }
+            }
+            if (!ok || (is_new && !has_size)) {
+                std::cout << "Error: Usage: set cache L<n> size=<bytes> [assoc=<ways>] [block=<bytes>] (size required for a new level).\n";
+                continue;
+            }
+
+            try {
+                cache_system.configure_level(level_id, spec);
+                std::cout << "Cache L" << level_id << " set to " << spec.size << "B, " << spec.associativity << "-way, "
+                          << spec.block_size << "B blocks (" << cache_system.depth() << " levels, caches flushed).\n";
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
         else if (cmd == "set" && tokens.size() >= 3 && tokens[1] == "allocator") {
             std::string strat = tokens[2];
             if (strat == "buddy") {
                 current_allocator = &buddy_alloc;
                 std::cout << "Allocator set to Buddy System.\n";
+            } else if (strat == "tlsf") {
+                current_allocator = &tlsf_alloc;
+                std::cout << "Allocator set to TLSF.\n";
+            } else if (strat == "slab") {
+                current_allocator = &slab_alloc;
+                std::cout << "Allocator set to Slab (pages from a private buddy arena).\n";
             } else {
                 current_allocator = &linear_alloc;
                 if (strat == "best_fit") current_strategy = Bestfit;
@@ -146,15 +308,292 @@ int main() {
             std::cout << "Block " << tokens[1] << " freed.\n";
         }
 
+        else if (cmd == "malloc_aligned" && tokens.size() >= 3) {
+            int id = current_allocator->allocate_aligned(std::stoul(tokens[1]), std::stoul(tokens[2]), current_strategy);
+            if (id != -1) {
+                std::cout << "Allocated block id=" << id << " at address=0x" 
+                          << std::hex << std::setfill('0') << std::setw(4) << current_allocator->get_address(id) 
+                          << std::dec << "\n";
+            } else {
+                std::cout << "Allocation failed.\n";
+            }
+        }
+
+        else if (cmd == "realloc" && tokens.size() >= 3) {
+            int old_id = std::stoi(tokens[1]);
+            int id = current_allocator->reallocate(old_id, std::stoul(tokens[2]), current_strategy);
+            if (id == -1) {
+                std::cout << "Reallocation failed.\n";
+            } else {
+                std::cout << (id == old_id ? "Block " + tokens[1] + " resized in place"
+                                           : "Block " + tokens[1] + " moved to id=" + std::to_string(id))
+                          << " at address=0x" << std::hex << std::setfill('0') << std::setw(4)
+                          << current_allocator->get_address(id) << std::dec << "\n";
+            }
+        }
+
+        else if (cmd == "malloc_batch" && tokens.size() >= 3) {
+            u64 count = 0, size = 0;
+            if (!parse_size(tokens[1], count) || !parse_size(tokens[2], size)) {
+                std::cout << "Error: Usage: malloc_batch <count> <size>.\n";
+                continue;
+            }
+            int first = -1, last = -1;
+            size_t done = current_allocator->allocate_repeated(count, size, current_strategy, first, last);
+            std::cout << "Allocated " << done << " of " << count << " blocks";
+            if (done > 0) std::cout << " (ids " << first << "-" << last << ")";
+            std::cout << ".\n";
+        }
+
+        else if (cmd == "free_range" && tokens.size() >= 3) {
+            int first = 0, last = 0;
+            try {
+                first = std::stoi(tokens[1]);
+                last = std::stoi(tokens[2]);
+            } catch (...) {
+                std::cout << "Error: Usage: free_range <id1> <id2>.\n";
+                continue;
+            }
+            current_allocator->deallocate_range(first, last);
+            std::cout << "Blocks " << tokens[1] << "-" << tokens[2] << " freed.\n";
+        }
+
+        else if (cmd == "compact") {
+            if (current_allocator != &linear_alloc) {
+                std::cout << "Error: Compaction is only supported by the linear allocator.\n";
+            } else {
+                u64 budget = SIZE_MAX;
+                if (tokens.size() >= 2 && !parse_size(tokens[1], budget)) {
+                    std::cout << "Error: Usage: compact [byte_budget].\n";
+                    continue;
+                }
+                size_t moved = linear_alloc.compact(budget, &cache_system);
+                std::cout << "Compaction moved " << moved << " bytes"
+                          << (linear_alloc.is_compacted() ? " (heap fully compacted).\n" : ".\n");
+            }
+        }
+
         else if (cmd == "read" || cmd == "write") {
             if (tokens.size() < 2) continue;
             u64 v_addr = std::stoull(tokens[1]);
-            std::string translation_report;
-            ll p_addr = mmu.translate(v_addr, (cmd == "write"), tlb, translation_report);
-            
-            std::cout << "[MMU] " << translation_report << "\n";
-            if (p_addr != -1) {
-                std::cout << "[Cache] " << cache_system.request((size_t)p_addr, (cmd == "write")) << "\n";
+            Translation t = mmu.translate(v_addr, (cmd == "write"), tlb);
+
+            static const char* const sources[] = {"TLB Hit", "STLB Hit", "Page Table Hit", "Page Fault", "COW Fault", "Invalid Address"};
+            std::cout << "[MMU] " << sources[t.source] << "\n";
+            if (t.physical_addr != -1) {
+                AccessResult r = cache_system.request((size_t)t.physical_addr, (cmd == "write"));
+                if (r.hit_level) std::cout << "[Cache] L" << int(r.hit_level) << " Hit\n";
+                else std::cout << "[Cache] RAM Miss (Fetched to Caches)\n";
+                if (r.writeback) std::cout << "[Cache] Dirty line written back to memory\n";
+            }
+        }
+
+        else if (cmd == "bench" && tokens.size() >= 2) {
+            int max_threads = std::stoi(tokens[1]);
+            size_t ops = tokens.size() >= 3 ? std::stoul(tokens[2]) : 100000;
+            ConcurrentAllocator::benchmark(*current_allocator, max_threads, ops);
+        }
+
+        else if (cmd == "init" && tokens.size() >= 2 && tokens[1] == "vm") {
+            // Unspecified sizes keep their current value.
+            u64 page = mmu.get_page_size(), virt = mmu.get_virtual_size(), phys = mmu.get_physical_size();
+            bool ok = true;
+            for (size_t i = 2; i < tokens.size() && ok; i++) {
+                size_t eq = tokens[i].find('=');
+                std::string key = tokens[i].substr(0, eq);
+                u64 val = 0;
+                ok = eq != std::string::npos && parse_size(tokens[i].substr(eq + 1), val);
+                if (key == "page") page = val;
+                else if (key == "virt") virt = val;
+                else if (key == "phys") phys = val;
+                else ok = false;
+            }
+            if (!ok) {
+                std::cout << "Error: Usage: init vm [page=<bytes>] [virt=<bytes|2^n>] [phys=<bytes|2^n>].\n";
+                continue;
+            }
+            try {
+                mmu.configure(page, virt, phys);
+                tlb.reset();
+                std::cout << "Virtual memory set to " << page << "B pages, " << virt << "B virtual, " << phys << "B physical ("
+                          << (mmu.get_page_table().is_flat() ? "flat" : "4-level") << " page table).\n";
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if (cmd == "init" && tokens.size() >= 2 && tokens[1] == "swap") {
+            if (tokens.size() >= 3 && tokens[2] == "off") {
+                mmu.set_swap_device(nullptr);
+                swap.reset();
+                std::cout << "Swap device detached.\n";
+                continue;
+            }
+            SwapSpec spec;
+            bool ok = true;
+            for (size_t i = 2; i < tokens.size() && ok; i++) {
+                size_t eq = tokens[i].find('=');
+                std::string key = tokens[i].substr(0, eq);
+                u64 val = 0;
+                ok = eq != std::string::npos;
+                if (ok && key == "file") {
+                    spec.path = tokens[i].substr(eq + 1);
+                    continue;
+                }
+                ok = ok && parse_size(tokens[i].substr(eq + 1), val) && (key == "size" || val <= 1u << 30);
+                if (key == "size") spec.size = val;
+                else if (key == "latency") spec.latency_ns = val * 1000;
+                else if (key == "bandwidth") spec.bandwidth = val << 20;
+                else if (key == "readahead") spec.readahead = static_cast<unsigned>(val);
+                else if (key == "queue") spec.queue_depth = static_cast<unsigned>(val);
+                else if (key == "gap") spec.gap_ns = val;
+                else ok = false;
+            }
+            if (!ok) {
+                std::cout << "Error: Usage: init swap [size=<bytes|2^n>] [latency=<us>] [bandwidth=<MB/s>] [readahead=<pages>] [queue=<n>] [gap=<ns>] [file=<path>] | init swap off.\n";
+                continue;
+            }
+            try {
+                auto fresh = std::make_unique<SwapDevice>(spec, mmu.get_page_size());
+                mmu.set_swap_device(fresh.get());
+                swap = std::move(fresh);
+                std::cout << "Swap device of " << spec.size << "B in " << (spec.path.empty() ? "a temporary file" : spec.path)
+                          << ": " << spec.latency_ns / 1000 << "us latency, " << (spec.bandwidth >> 20) << "MB/s, readahead "
+                          << spec.readahead << " pages, writeback queue " << spec.queue_depth << ".\n";
+            } catch (const std::exception& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if (cmd == "set" && tokens.size() >= 4 && tokens[1] == "tlb") {
+            std::string lvl = tokens[2];
+            std::transform(lvl.begin(), lvl.end(), lvl.begin(), ::toupper);
+            if (lvl != "L1" && lvl != "L2") {
+                std::cout << "Error: Unknown TLB level '" << tokens[2] << "'. Use L1 or L2.\n";
+                continue;
+            }
+            int level = lvl == "L1" ? 1 : 2;
+            int entries = tlb.level(level).size(), assoc = tlb.level(level).associativity();
+            bool ok = true;
+            if (tokens[3] == "off") {
+                entries = 0;
+            } else {
+                for (size_t i = 3; i < tokens.size() && ok; i++) {
+                    size_t eq = tokens[i].find('=');
+                    std::string key = tokens[i].substr(0, eq);
+                    u64 val = 0;
+                    ok = eq != std::string::npos && parse_size(tokens[i].substr(eq + 1), val) && val <= 1u << 20;
+                    if (key == "entries") entries = static_cast<int>(val);
+                    else if (key == "assoc") assoc = static_cast<int>(val);
+                    else ok = false;
+                }
+            }
+            if (!ok) {
+                std::cout << "Error: Usage: set tlb <L1|L2> entries=<n> [assoc=<ways>] | set tlb L2 off.\n";
+                continue;
+            }
+            try {
+                tlb.configure(level, entries, assoc);
+                if (entries == 0) std::cout << "TLB " << lvl << " disabled (TLBs flushed, statistics reset).\n";
+                else std::cout << "TLB " << lvl << " set to " << entries << " entries, " << assoc << "-way (TLBs flushed, statistics reset).\n";
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if (cmd == "hugepage" && tokens.size() >= 3) {
+            u64 v_addr = 0, size = 0;
+            if (!parse_size(tokens[1], v_addr) || !parse_size(tokens[2], size)) {
+                std::cout << "Error: Usage: hugepage <v_addr> <size>.\n";
+                continue;
+            }
+            try {
+                mmu.map_huge(v_addr, size, tlb);
+                std::cout << "Huge page of " << size << "B mapped at " << v_addr << ".\n";
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if ((cmd == "fork" || cmd == "switch") && tokens.size() >= 2) {
+            int pid = 0;
+            try {
+                pid = std::stoi(tokens[1]);
+            } catch (...) {
+                std::cout << "Error: Usage: " << cmd << " <pid>.\n";
+                continue;
+            }
+            try {
+                if (cmd == "fork") {
+                    int parent = mmu.current_pid();
+                    mmu.fork(pid, tlb);
+                    std::cout << "Process " << pid << " forked from " << parent << " (pages shared copy-on-write).\n";
+                } else {
+                    mmu.switch_to(pid);
+                    std::cout << "Switched to process " << pid << ".\n";
+                }
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if (cmd == "init" && tokens.size() >= 3 && tokens[1] == "cores") {
+            size_t depth = cache_system.depth();
+            if (depth < 2) {
+                std::cout << "Error: Multi-core mode needs at least two cache levels (private + shared).\n";
+                continue;
+            }
+            std::vector<CacheLevelSpec> private_levels;
+            for (size_t i = 1; i < depth; i++) private_levels.push_back(cache_system.spec(static_cast<int>(i)));
+            int n = 0, threads = 1;
+            try {
+                n = std::stoi(tokens[2]);
+                if (tokens.size() >= 4) threads = std::stoi(tokens[3]);
+            } catch (...) {
+                std::cout << "Error: Usage: init cores <n> [host_threads].\n";
+                continue;
+            }
+            try {
+                multicore = std::make_unique<MultiCoreSystem>(n, private_levels,
+                                                              cache_system.spec(static_cast<int>(depth)),
+                                                              cache_system.replacement_policy(), threads);
+                std::cout << "Multi-core system: " << multicore->num_cores() << " cores with private L1-L" << depth - 1
+                          << ", shared L" << depth << " with MESI directory, " << threads << " host thread(s).\n";
+            } catch (const std::invalid_argument& e) {
+                std::cout << "Error: " << e.what() << ".\n";
+            }
+        }
+
+        else if (cmd == "core" && tokens.size() >= 4 && (tokens[2] == "read" || tokens[2] == "write")) {
+            int core = 0;
+            u64 p_addr = 0;
+            try {
+                core = std::stoi(tokens[1]);
+                p_addr = std::stoull(tokens[3]);
+            } catch (...) {
+                std::cout << "Error: Usage: core <id> <read|write> <p_addr>.\n";
+                continue;
+            }
+            if (!multicore) {
+                std::cout << "Error: Run 'init cores <n>' first.\n";
+            } else if (core < 0 || core >= multicore->num_cores()) {
+                std::cout << "Error: Core " << core << " does not exist.\n";
+            } else {
+                multicore->enqueue(core, p_addr, tokens[2] == "write");
+            }
+        }
+
+        else if (cmd == "sync") {
+            if (!multicore) std::cout << "Error: Run 'init cores <n>' first.\n";
+            else std::cout << "Synchronized: " << multicore->sync() << " accesses across " << multicore->num_cores() << " cores.\n";
+        }
+
+        else if (cmd == "stats" && tokens.size() >= 2 && tokens[1] == "cores") {
+            if (!multicore) {
+                std::cout << "Error: Run 'init cores <n>' first.\n";
+            } else {
+                multicore->sync();
+                multicore->display_stats();
             }
         }
 
@@ -162,6 +601,8 @@ int main() {
             current_allocator->get_statistics();
             cache_system.display_all_stats();
             mmu.get_statistics();
+            tlb.get_statistics();
+            if (swap) swap->get_statistics();
         }
 
         else if (cmd == "dump" && tokens.size() >= 2 && tokens[1] == "memory") {
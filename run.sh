@@ -25,12 +25,14 @@ echo "========================================"
 echo " [RUNNING TESTS]"
 echo "========================================"
 
-idx=1
 found_test=false
 
 for test_file in "$TEST_DIR"/test*; do
     if [ -f "$test_file" ]; then
         found_test=true
+        # testN.txt writes outputN, whatever order the glob lists them in.
+        idx=$(basename "$test_file" .txt)
+        idx=${idx#test}
         output_file="$OUTPUT_DIR/output$idx"
 
         echo ""
@@ -43,7 +45,6 @@ for test_file in "$TEST_DIR"/test*; do
         $EXECUTABLE < "$test_file" > "$output_file"
 
         echo " [OK] Output saved to $output_file"
-        ((idx++))
     fi
 done
 
@@ -3,7 +3,29 @@
 #include <vector>
 #include <unordered_map>
 #include <algorithm>
+#include <memory>
  enum Alloc_Algo{Firstfit,Bestfit,Worstfit};
+ // Allocator metrics kept up to date on every allocate/split/coalesce, so a snapshot is O(1).
+ struct AllocatorStats{
+    size_t total_size=0;
+    size_t used=0;
+    size_t free=0;
+    size_t internal_frag=0;
+    size_t largest_free=0;
+    size_t free_blocks=0;
+    size_t free_histogram[64]={}; // free blocks with size in [2^k, 2^(k+1))
+ };
+ inline int size_bucket(size_t sz){ return sz ? 63-__builtin_clzll(sz) : 0; }
+ inline void print_free_histogram(const AllocatorStats& s){
+    std::cout << "Free-block histogram (log2):";
+    bool any=false;
+    for(int k=0;k<64;k++){
+        if(!s.free_histogram[k]) continue;
+        std::cout << " " << (1ULL<<k) << "B:" << s.free_histogram[k];
+        any=true;
+    }
+    std::cout << (any ? "\n" : " none\n");
+ }
  class Allocator{
     public:
     virtual void init(size_t mem_size)=0;// delete all old nodes and creates single Giant free block.
@@ -12,5 +34,65 @@
     virtual size_t get_address(int block_id) = 0; 
     virtual void display()=0; // prints the state of Linked list.
     virtual void get_statistics()=0; // print metrics .
+    virtual AllocatorStats snapshot()=0; // same metrics as a struct, O(1).
+    virtual int next_block_id()=0; // the id the next allocation will get; every live id is below it.
+    // Batch entry points; ids[i] is the id for sizes[i] or -1, exactly as if allocate()
+    // had been called in order. Backends override these to amortize index work.
+    virtual size_t allocate_batch(const std::vector<size_t>& sizes, Alloc_Algo algo, std::vector<int>& ids){
+        ids.resize(sizes.size());
+        size_t done=0;
+        for(size_t i=0;i<sizes.size();i++){
+            ids[i]=allocate(sizes[i],algo);
+            if(ids[i]!=-1) done++;
+        }
+        return done;
+    }
+    // count blocks of mem_size, fed to allocate_batch in bounded chunks so no array of
+    // count entries is built. Stops after the first chunk with a failure, since nothing
+    // was freed in between; first_id/last_id span the ids handed out (-1 if none).
+    size_t allocate_repeated(size_t count, size_t mem_size, Alloc_Algo algo, int& first_id, int& last_id){
+        const size_t CHUNK=4096;
+        std::vector<int> ids;
+        size_t done=0;
+        first_id=last_id=-1;
+        while(count>0){
+            std::vector<size_t> sizes(std::min(count,CHUNK),mem_size);
+            size_t got=allocate_batch(sizes,algo,ids);
+            for(int id : ids){
+                if(id==-1) continue;
+                if(first_id==-1) first_id=id;
+                last_id=id;
+            }
+            done+=got;
+            count-=sizes.size();
+            if(got<sizes.size()) break;
+        }
+        return done;
+    }
+    virtual void deallocate_range(int first_id, int last_id){ // frees every id in [first_id, last_id]
+        last_id=std::min(last_id,next_block_id()-1); // also keeps id++ from overflowing
+        for(int id=std::max(first_id,1);id<=last_id;id++) deallocate(id);
+    }
+    // align must be a power of two. Backends without alignment support only succeed
+    // when the natural placement already happens to be aligned.
+    virtual int allocate_aligned(size_t mem_size, size_t align, Alloc_Algo algo){
+        if(align==0 || (align&(align-1))) return -1;
+        int id=allocate(mem_size,algo);
+        if(id!=-1 && get_address(id)%align!=0){ deallocate(id); return -1; }
+        return id;
+    }
+    // Returns the id now holding the block: block_id if resized in place, a new id if
+    // it had to move (placed with algo), or -1 (old block untouched) on failure.
+    virtual int reallocate(int block_id, size_t new_size, Alloc_Algo algo){
+        if(new_size==0) return -1;
+        int id=allocate(new_size,algo);
+        if(id!=-1) deallocate(block_id);
+        return id;
+    }
+    // A fresh, uninitialized backend of the same kind, or nullptr when there is none.
+    virtual std::unique_ptr<Allocator> make_empty() const { return nullptr; }
+    void set_announce(bool on){ announce=on; } // whether init prints its banner
     virtual ~Allocator() {};
+    protected:
+    bool announce=true;
  };
\ No newline at end of file
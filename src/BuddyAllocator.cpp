@@ -2,21 +2,66 @@
 #include <iostream>
 #include <algorithm>
 #include <climits>
+#include <iomanip>
 
 BuddyAllocator::~BuddyAllocator() {
-    for (auto& entry : allocated) {
-        delete entry.second;
-    }
-    allocated.clear();
+    release_all();
+}
 
-    for (auto head : free_lists) {
-        while (head) {
-            BuddyBlock* temp = head;
-            head = head->next;
-            delete temp;
-        }
-    }
+void BuddyAllocator::release_all() {
+    pairs.reset();
+    root = BuddyBlock(0, 0);
+    allocated.clear();
     free_lists.clear();
+    nonempty_orders = 0;
+    free_mem = free_blocks = requested_bytes = 0;
+    realloc_calls = realloc_in_place = 0;
+    std::fill(std::begin(free_per_order), std::end(free_per_order), 0);
+}
+
+// Only for a block with a parent: the halves of a pair sit next to each other.
+BuddyBlock* BuddyAllocator::buddy_of(BuddyBlock* blk) {
+    return (blk->address & blk->size) ? blk - 1 : blk + 1;
+}
+
+// Splits blk in two, frees the upper half and returns the lower one.
+BuddyBlock* BuddyAllocator::split(BuddyBlock* blk) {
+    BuddyPair* pair = pairs.create(blk);
+    push_free(&pair->half[1], order_of(pair->half[1].size));
+    return &pair->half[0];
+}
+
+// Joins blk with its free buddy and returns the block they were split from.
+BuddyBlock* BuddyAllocator::merge(BuddyBlock* blk) {
+    BuddyBlock* buddy = buddy_of(blk);
+    unlink_free(buddy, order_of(buddy->size));
+    BuddyBlock* parent = blk->parent;
+    pairs.destroy(reinterpret_cast<BuddyPair*>(std::min(blk, buddy)));
+    return parent;
+}
+
+void BuddyAllocator::push_free(BuddyBlock* blk, int order) {
+    blk->prev = nullptr;
+    blk->next = free_lists[order];
+    if (blk->next) blk->next->prev = blk;
+    free_lists[order] = blk;
+    blk->free = true;
+    nonempty_orders |= uint64_t(1) << order;
+    free_mem += blk->size;
+    free_blocks++;
+    free_per_order[order]++;
+}
+
+void BuddyAllocator::unlink_free(BuddyBlock* blk, int order) {
+    if (blk->prev) blk->prev->next = blk->next;
+    else free_lists[order] = blk->next;
+    if (blk->next) blk->next->prev = blk->prev;
+    blk->next = blk->prev = nullptr;
+    blk->free = false;
+    if (!free_lists[order]) nonempty_orders &= ~(uint64_t(1) << order);
+    free_mem -= blk->size;
+    free_blocks--;
+    free_per_order[order]--;
 }
 
 int BuddyAllocator::order_of(size_t x) {
@@ -50,18 +95,7 @@ size_t BuddyAllocator::next_power_of_2(size_t x) {
 }
 
 void BuddyAllocator::init(size_t size) {
-    for (auto& entry : allocated) {
-        delete entry.second;
-    }
-    allocated.clear();
-
-    for (auto head : free_lists) {
-        while (head) {
-            BuddyBlock* temp = head;
-            head = head->next;
-            delete temp;
-        }
-    }
+    release_all();
 
     total_size = next_power_of_2(size);
     if (total_size == 0) {
@@ -71,11 +105,11 @@ void BuddyAllocator::init(size_t size) {
 
     int max_order = order_of(total_size);
     free_lists.assign(max_order + 1, nullptr);
-    next_id = 1;
 
-    free_lists[max_order] = new BuddyBlock(0, total_size);
+    root = BuddyBlock(0, total_size);
+    push_free(&root, max_order);
 
-    std::cout << "[System] Buddy Memory Initialized: "
+    if (announce) std::cout << "[System] Buddy Memory Initialized: "
               << total_size << " bytes (Order " << max_order << ").\n";
 }
 
@@ -88,81 +122,111 @@ int BuddyAllocator::allocate(size_t size, Alloc_Algo) {
     int req_order = order_of(req_size);
     if (req_order == -1) return -1;
 
-    int current_order = req_order;
-    int max_order = static_cast<int>(free_lists.size()) - 1;
-
-    while (current_order <= max_order && free_lists[current_order] == nullptr) {
-        current_order++;
-    }
-    if (current_order > max_order) return -1;
+    // Smallest non-empty order >= req_order, found with one bit scan.
+    uint64_t candidates = nonempty_orders & (~uint64_t(0) << req_order);
+    if (candidates == 0) return -1;
+    int current_order = __builtin_ctzll(candidates);
 
     BuddyBlock* blk = free_lists[current_order];
-    free_lists[current_order] = blk->next;
-    blk->next = nullptr;
+    unlink_free(blk, current_order);
 
     while (current_order > req_order) {
         current_order--;
-        size_t half = blk->size / 2;
-
-        BuddyBlock* buddy = new BuddyBlock(blk->address + half, half);
-        blk->size = half;
-
-        buddy->next = free_lists[current_order];
-        free_lists[current_order] = buddy;
+        blk = split(blk);
     }
 
-    blk->id = next_id++;
-    allocated[blk->id] = blk;
+    blk->id = allocated.insert(blk);
+    blk->req_size = size;
+    requested_bytes += size;
     return blk->id;
 }
 
 void BuddyAllocator::deallocate(int id) {
-    auto it = allocated.find(id);
-    if (it == allocated.end()) return;
+    BuddyBlock* blk;
+    if (!allocated.erase(id, &blk)) return;
 
-    BuddyBlock* blk = it->second;
-    size_t addr = blk->address;
-    size_t size = blk->size;
+    requested_bytes -= blk->req_size;
+    blk->id = 0;
+    blk->req_size = 0;
 
-    allocated.erase(it);
-    delete blk;
+    while (blk->parent && buddy_of(blk)->free) {
+        blk = merge(blk);
+    }
+    push_free(blk, order_of(blk->size));
+}
 
-    while (size < total_size) {
-        size_t buddy_addr = addr ^ size;
-        int order = order_of(size);
+// Buddy blocks are naturally aligned to their own size, so rounding the
+// request up to the alignment is all that is needed.
+int BuddyAllocator::allocate_aligned(size_t size, size_t align, Alloc_Algo algo) {
+    if (size == 0 || align == 0 || (align & (align - 1)) != 0) return -1;
+    int id = allocate(std::max(size, align), algo);
+    if (id != -1) {
+        BuddyBlock* blk = *allocated.find(id);
+        requested_bytes -= blk->req_size - size;
+        blk->req_size = size;
+    }
+    return id;
+}
 
-        if (order == -1 || order >= static_cast<int>(free_lists.size()) - 1) break;
+int BuddyAllocator::reallocate(int id, size_t new_size, Alloc_Algo algo) {
+    BuddyBlock** slot = allocated.find(id);
+    if (!slot || new_size == 0) return -1;
+    BuddyBlock* blk = *slot;
+    realloc_calls++;
 
-        BuddyBlock* prev = nullptr;
-        BuddyBlock* curr = free_lists[order];
+    size_t req_size = next_power_of_2(new_size);
+    if (req_size == 0 || req_size > total_size) return -1;
 
-        while (curr && curr->address != buddy_addr) {
-            prev = curr;
-            curr = curr->next;
+    bool in_place = true;
+    if (req_size < blk->size) {
+        // Shrink: hand back upper halves; their buddy (blk) is in use, so they cannot merge.
+        while (blk->size > req_size) {
+            BuddyBlock* lower = split(blk);
+            lower->id = blk->id;
+            lower->req_size = blk->req_size;
+            blk->id = 0;
+            blk = lower;
+        }
+    } else if (req_size > blk->size) {
+        // Grow: possible only while blk is the lower half and its buddy is free at every level.
+        for (BuddyBlock* b = blk; b->size < req_size; b = b->parent) {
+            if ((b->address & b->size) != 0 || !buddy_of(b)->free) {
+                in_place = false;
+                break;
+            }
+        }
+        if (in_place) {
+            while (blk->size < req_size) {
+                BuddyBlock* whole = merge(blk);
+                whole->id = blk->id;
+                whole->req_size = blk->req_size;
+                blk = whole;
+            }
         }
-        if (!curr) break;
-
-        if (prev) prev->next = curr->next;
-        else free_lists[order] = curr->next;
-
-        delete curr;
-
-        addr = std::min(addr, buddy_addr);
-        size <<= 1;
     }
 
-    int final_order = order_of(size);
-    if (final_order != -1 && final_order < static_cast<int>(free_lists.size())) {
-        BuddyBlock* merged = new BuddyBlock(addr, size);
-        merged->next = free_lists[final_order];
-        free_lists[final_order] = merged;
+    if (in_place) {
+        *slot = blk;
+        requested_bytes += new_size - blk->req_size;
+        blk->req_size = new_size;
+        realloc_in_place++;
+        return id;
     }
+
+    int new_id = allocate(new_size, algo);
+    if (new_id != -1) deallocate(id);
+    return new_id;
 }
 
 size_t BuddyAllocator::get_address(int id) {
-    auto it = allocated.find(id);
-    if (it == allocated.end()) return SIZE_MAX;
-    return it->second->address;
+    BuddyBlock** blk = allocated.find(id);
+    if (!blk) return SIZE_MAX;
+    return (*blk)->address;
+}
+
+size_t BuddyAllocator::get_block_size(int id) {
+    BuddyBlock** blk = allocated.find(id);
+    return blk ? (*blk)->size : 0;
 }
 
 void BuddyAllocator::display() {
@@ -179,20 +243,28 @@ void BuddyAllocator::display() {
     }
 }
 
-void BuddyAllocator::get_statistics() {
-    size_t free_mem = 0, free_blocks = 0;
-
-    for (auto head : free_lists) {
-        while (head) {
-            free_mem += head->size;
-            free_blocks++;
-            head = head->next;
-        }
-    }
+AllocatorStats BuddyAllocator::snapshot() {
+    AllocatorStats s;
+    s.total_size = total_size;
+    s.free = free_mem;
+    s.used = total_size - free_mem;
+    s.internal_frag = s.used - requested_bytes;
+    s.free_blocks = free_blocks;
+    if (nonempty_orders) s.largest_free = size_t(1) << (63 - __builtin_clzll(nonempty_orders));
+    std::copy(std::begin(free_per_order), std::end(free_per_order), s.free_histogram);
+    return s;
+}
 
+void BuddyAllocator::get_statistics() {
     std::cout << "Total Memory      : " << total_size << "\n";
     std::cout << "Allocated Blocks  : " << allocated.size() << "\n";
     std::cout << "Free Blocks       : " << free_blocks << "\n";
     std::cout << "Free Memory       : " << free_mem << "\n";
     std::cout << "Used Memory       : " << (total_size - free_mem) << "\n";
+    print_free_histogram(snapshot());
+    if (realloc_calls > 0) {
+        std::cout << "Realloc In-Place  : " << std::fixed << std::setprecision(0)
+                  << (double)realloc_in_place / realloc_calls * 100.0 << "% ("
+                  << realloc_in_place << "/" << realloc_calls << ")\n";
+    }
 }
@@ -1,35 +1,77 @@
 #pragma once
 #include <vector>
 #include <iostream>
-#include <unordered_map>
 #include <algorithm>
 #include <cmath>
+#include <cstdint>
 #include "Allocator.h"
+#include "NodePool.h"
+#include "HandleTable.h"
 
 struct BuddyBlock {
     size_t address;
     size_t size;
     int id;
+    size_t req_size;
+    bool free;
     BuddyBlock* next;
-    BuddyBlock(size_t addr, size_t s) : address(addr), size(s), id(0), next(nullptr) {}
+    BuddyBlock* prev;
+    BuddyBlock* parent;   // the block this one was split from, nullptr for the whole arena
+    BuddyBlock(size_t addr, size_t s, BuddyBlock* up = nullptr)
+        : address(addr), size(s), id(0), req_size(0), free(false), next(nullptr), prev(nullptr), parent(up) {}
+};
+
+// Splitting a block creates both halves together, so a block's buddy is the
+// other half of its pair and never has to be looked up by address.
+struct BuddyPair {
+    BuddyBlock half[2];
+    explicit BuddyPair(BuddyBlock* parent)
+        : half{BuddyBlock(parent->address, parent->size / 2, parent),
+               BuddyBlock(parent->address + parent->size / 2, parent->size / 2, parent)} {}
 };
 
 class BuddyAllocator : public Allocator {
 private:
     size_t total_size{};
-    int next_id{1};
     std::vector<BuddyBlock*> free_lists;
-    std::unordered_map<int, BuddyBlock*> allocated;
-    
+    BuddyBlock root{0, 0};
+    NodePool<BuddyPair> pairs;
+    HandleTable<BuddyBlock*> allocated;
+
+    // Every block is a node in the split tree, rooted at the whole arena, so
+    // the metadata grows with the block count rather than the arena size. A
+    // buddy's status is its node's free flag, and nonempty_orders has bit k
+    // set while free_lists[k] is non-empty.
+    uint64_t nonempty_orders = 0;
+
+    // Running totals for snapshot(); free_per_order doubles as the log2 histogram.
+    size_t free_mem = 0, free_blocks = 0, requested_bytes = 0;
+    size_t free_per_order[64] = {};
+    size_t realloc_calls = 0, realloc_in_place = 0;
+
     size_t next_power_of_2(size_t x);
     int order_of(size_t x);
+    static BuddyBlock* buddy_of(BuddyBlock* blk);
+    BuddyBlock* split(BuddyBlock* blk);
+    BuddyBlock* merge(BuddyBlock* blk);
+    void push_free(BuddyBlock* blk, int order);
+    void unlink_free(BuddyBlock* blk, int order);
+    void release_all();
 
 public:
+    // announce = false keeps init quiet, for a buddy used as another backend's page source.
+    explicit BuddyAllocator(bool announce_init = true) { announce = announce_init; }
+    std::unique_ptr<Allocator> make_empty() const override { return std::make_unique<BuddyAllocator>(); }
     void init(size_t size) override;
     int allocate(size_t size, Alloc_Algo algo = Firstfit) override; 
     void deallocate(int id) override;
     size_t get_address(int Id) override;
+    int next_block_id() override { return allocated.next_id(); }
+    size_t get_block_size(int id);   // the rounded block held by id, 0 if unknown
     void display() override;
     void get_statistics() override;
+    AllocatorStats snapshot() override;
+    int allocate_aligned(size_t size, size_t align, Alloc_Algo algo) override;
+    int reallocate(int id, size_t new_size, Alloc_Algo algo = Firstfit) override; // absorbs free buddies to grow in place
     ~BuddyAllocator();
 };
\ No newline at end of file
@@ -2,135 +2,275 @@
 #include <iostream>
 #include <iomanip>
 #include <cmath>
-#include <limits>
 #include <stdexcept>
 
-CacheLevel::CacheLevel(int id, u64 s, u64 bs, int assoc, ReplacementPolicy p)
-    : level_id(id), size(s), block_size(bs), associativity(assoc), policy(p) {
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#define CACHE_SIMD_X86 1
+#endif
 
-    if (s == 0 || bs == 0 || assoc == 0) throw std::invalid_argument("Params cannot be 0");
+// Index of the first way in tags[0..n) equal to tag, or -1.
+static int match_scalar(const u64* tags, int n, u64 tag) {
+    for (int i = 0; i < n; i++) if (tags[i] == tag) return i;
+    return -1;
+}
+
+#ifdef CACHE_SIMD_X86
+__attribute__((target("sse4.1")))
+static int match_sse41(const u64* tags, int n, u64 tag) {
+    const __m128i key = _mm_set1_epi64x(static_cast<long long>(tag));
+    int i = 0;
+    for (; i + 2 <= n; i += 2) {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tags + i));
+        int mask = _mm_movemask_pd(_mm_castsi128_pd(_mm_cmpeq_epi64(v, key)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    for (; i < n; i++) if (tags[i] == tag) return i;
+    return -1;
+}
+
+__attribute__((target("avx2")))
+static int match_avx2(const u64* tags, int n, u64 tag) {
+    const __m256i key = _mm256_set1_epi64x(static_cast<long long>(tag));
+    int i = 0;
+    for (; i + 4 <= n; i += 4) {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(tags + i));
+        int mask = _mm256_movemask_pd(_mm256_castsi256_pd(_mm256_cmpeq_epi64(v, key)));
+        if (mask) return i + __builtin_ctz(mask);
+    }
+    for (; i < n; i++) if (tags[i] == tag) return i;
+    return -1;
+}
+#endif
+
+using MatchFn = int (*)(const u64*, int, u64);
+
+static MatchFn pick_match_fn() {
+#ifdef CACHE_SIMD_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return match_avx2;
+    if (__builtin_cpu_supports("sse4.1")) return match_sse41;
+#endif
+    return match_scalar;
+}
+
+static const MatchFn match_wide = pick_match_fn();
+
+int match_tags(const u64* tags, int n, u64 tag) { return match_wide(tags, n, tag); }
+
+RuntimeGeometry::RuntimeGeometry(u64 size, u64 bs, int assoc) : block_size(bs), associativity(assoc) {
+    if (size == 0 || bs == 0 || assoc == 0) throw std::invalid_argument("Params cannot be 0");
+    if ((bs & (bs - 1)) != 0) throw std::invalid_argument("Block size must be power of 2");
     num_sets = size / (block_size * associativity);
+    if (num_sets == 0) throw std::invalid_argument("Cache smaller than one set");
     if ((num_sets & (num_sets - 1)) != 0) throw std::invalid_argument("Sets must be power of 2");
 
     offset_bits = static_cast<u64>(std::log2(block_size));
     index_bits  = static_cast<u64>(std::log2(num_sets));
-    sets.resize(num_sets, std::vector<CacheLine>(associativity));
 }
 
-void CacheLevel::set_policy(ReplacementPolicy p) { policy = p; }
-
-bool CacheLevel::access(u64 address, bool is_write) {
-    access_counter++;
-    u64 index = (address >> offset_bits) % num_sets;
-    u64 tag = address >> (offset_bits + index_bits);
+template <u64 BS, u64 SETS, int ASSOC>
+static std::unique_ptr<CacheModel> make_fixed(int id, ReplacementPolicy p) {
+    switch (p) {
+    case FIFO:  return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, FIFO>>(id);
+    case LFU:   return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, LFU>>(id);
+    case PLRU:  return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, PLRU>>(id);
+    case SRRIP: return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, SRRIP>>(id);
+    case BRRIP: return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, BRRIP>>(id);
+    case DIP:   return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, DIP>>(id);
+    default:    return std::make_unique<FixedCacheLevel<BS, SETS, ASSOC, LRU>>(id);
+    }
+}
 
-    for (auto& line : sets[index]) {
-        if (line.valid && line.tag == tag) {
-            hits++;
-            line.last_access_time = access_counter;
-            line.freq++;
-            if (is_write) line.dirty = true;
-            return true;
-        }
+std::unique_ptr<CacheModel> make_cache_level(int id, u64 size, u64 block_size, int assoc, ReplacementPolicy p) {
+    if (size && block_size && assoc) {
+        u64 sets = size / (block_size * assoc);
+        if (block_size == 8 && sets == 8 && assoc == 1) return make_fixed<8, 8, 1>(id, p);
+        if (block_size == 16 && sets == 8 && assoc == 2) return make_fixed<16, 8, 2>(id, p);
+        if (block_size == 32 && sets == 4 && assoc == 4) return make_fixed<32, 4, 4>(id, p);
+        if (block_size == 64 && sets == 64 && assoc == 8) return make_fixed<64, 64, 8>(id, p);
     }
-    misses++;
-    return false;
+    return std::make_unique<CacheLevel>(id, size, block_size, assoc, p);
 }
 
-bool CacheLevel::insert(u64 address, bool is_write, u64& ev_addr, bool& ev_dirty) {
-    u64 index = (address >> offset_bits) % num_sets;
-    u64 tag = address >> (offset_bits + index_bits);
+MemoryHierarchy::MemoryHierarchy(const std::vector<CacheLevelSpec>& level_specs, ReplacementPolicy p,
+                                 InclusionPolicy mode)
+    : specs(level_specs), policy(p), inclusion(mode) {
+    rebuild();
+}
 
-    int victim = -1;
-    u64 min_val = std::numeric_limits<u64>::max();
+void MemoryHierarchy::rebuild() {
+    std::vector<std::unique_ptr<CacheModel>> fresh;
+    for (size_t i = 0; i < specs.size(); i++)
+        fresh.push_back(make_cache_level(static_cast<int>(i + 1), specs[i].size, specs[i].block_size,
+                                         specs[i].associativity, policy));
+    for (auto& level : fresh) level->set_miss_classification(classify_misses);
+    levels = std::move(fresh);
+    prefetchers.resize(levels.size());
+    pending_prefetches.clear();
+}
 
-    for (int i = 0; i < associativity; i++) {
-        if (!sets[index][i].valid) { victim = i; break; }
-        u64 val = (policy == LRU) ? sets[index][i].last_access_time : 
-                  (policy == FIFO) ? sets[index][i].insertion_time : sets[index][i].freq;
-        if (val < min_val) { min_val = val; victim = i; }
-    }
+void MemoryHierarchy::configure_level(int level_id, const CacheLevelSpec& spec) {
+    if (level_id < 1 || static_cast<size_t>(level_id) > specs.size() + 1)
+        throw std::invalid_argument("Levels must be added in order");
+    // Validate before touching the current configuration.
+    make_cache_level(level_id, spec.size, spec.block_size, spec.associativity, policy);
+    if (static_cast<size_t>(level_id) > specs.size()) specs.push_back(spec);
+    else specs[level_id - 1] = spec;
+    rebuild();
+    prefetchers[level_id - 1].reset();
+}
 
-    bool evicted = false;
-    if (sets[index][victim].valid) {
-        evicted = true;
-        ev_addr = (sets[index][victim].tag << (offset_bits + index_bits)) | (index << offset_bits);
-        ev_dirty = sets[index][victim].dirty;
-    }
+void MemoryHierarchy::truncate(int depth) {
+    if (depth < 1) throw std::invalid_argument("Hierarchy needs at least one level");
+    if (static_cast<size_t>(depth) >= specs.size()) return;
+    specs.resize(depth);
+    prefetchers.resize(depth);
+    rebuild();
+}
 
-    sets[index][victim] = {true, is_write, tag, access_counter, access_counter, 1};
-    return evicted;
+void MemoryHierarchy::set_inclusion(InclusionPolicy mode) {
+    inclusion = mode;
+    rebuild();
 }
 
-bool CacheLevel::invalidate(u64 address) {
-    u64 index = (address >> offset_bits) % num_sets;
-    u64 tag = address >> (offset_bits + index_bits);
-    for (auto& line : sets[index]) {
-        if (line.valid && line.tag == tag) {
-            bool was_dirty = line.dirty;
-            line.valid = false;
-            return was_dirty;
-        }
-    }
-    return false;
+void MemoryHierarchy::set_policy(ReplacementPolicy p) {
+    policy = p;
+    for (auto& level : levels) level->set_policy(p);
 }
 
-void CacheLevel::invalidate_frame(size_t start, size_t range) {
-    for (size_t a = start; a < start + range; a += block_size) invalidate(a);
+void MemoryHierarchy::set_miss_classification(bool on) {
+    classify_misses = on;
+    for (auto& level : levels) level->set_miss_classification(on);
 }
 
-MemoryHierarchy::MemoryHierarchy(CacheLevel* a, CacheLevel* b, CacheLevel* c) : l1(a), l2(b), l3(c) {}
+void MemoryHierarchy::set_prefetcher(int level_id, std::unique_ptr<Prefetcher> p) {
+    prefetchers[level_id - 1] = std::move(p);
+}
 
 void MemoryHierarchy::invalidate_physical_range(size_t addr, size_t size) {
-    l1->invalidate_frame(addr, size);
-    l2->invalidate_frame(addr, size);
-    l3->invalidate_frame(addr, size);
-}
-
-std::string MemoryHierarchy::request(u64 address, bool is_write) {
-    u64 ev_addr; bool ev_dirty;
-    if (l1->access(address, is_write)) return "L1 Hit";
-    
-    if (l2->access(address, is_write)) {
-        if (l1->insert(address, is_write, ev_addr, ev_dirty) && ev_dirty) handle_writeback(ev_addr, 1);
-        return "L2 Hit";
+    for (auto& level : levels) level->invalidate_frame(addr, size);
+}
+
+AccessResult MemoryHierarchy::request(u64 address, bool is_write) {
+    wrote_back = false;
+    size_t hit_at = demand(address, is_write);
+    for (size_t i = 0; i < pending_prefetches.size(); i++)
+        prefetch_fill(pending_prefetches[i].first, pending_prefetches[i].second);
+    pending_prefetches.clear();
+    uint8_t level = hit_at < levels.size() ? static_cast<uint8_t>(hit_at + 1) : 0;
+    return {level, wrote_back};
+}
+
+// Hands the demand access to the level's prefetcher; the proposals are filled
+// once the demand request has finished its own fills.
+void MemoryHierarchy::train(size_t idx, u64 address, bool hit) {
+    Prefetcher* pf = prefetchers[idx].get();
+    if (!pf) return;
+    u64 bs = levels[idx]->block_size();
+    proposals.clear();
+    pf->observe(address / bs * bs, hit, proposals);
+    for (u64 a : proposals) pending_prefetches.emplace_back(idx, a);
+}
+
+void MemoryHierarchy::prefetch_fill(size_t idx, u64 address) {
+    if (levels[idx]->probe(address)) return;
+    if (inclusion == EXCLUSIVE)
+        for (auto& level : levels) if (level->probe(address)) return;
+    if (inclusion == INCLUSIVE)   // keep the levels below a superset
+        for (size_t j = levels.size(); j-- > idx + 1;)
+            if (!levels[j]->probe(address)) fill(j, address, false);
+    u64 ev_addr; bool ev_dirty = false;
+    if (levels[idx]->insert_prefetch(address, ev_addr, ev_dirty)) evict(idx, ev_addr, ev_dirty);
+}
+
+// Index of the level that hit, or levels.size() when the request went to memory.
+size_t MemoryHierarchy::demand(u64 address, bool is_write) {
+    size_t n = levels.size();
+    size_t hit_at = n;
+    for (size_t i = 0; i < n; i++) {
+        bool hit = levels[i]->access(address, is_write);
+        train(i, address, hit);
+        if (hit) { hit_at = i; break; }
     }
-    
-    if (l3->access(address, is_write)) {
-        if (l2->insert(address, is_write, ev_addr, ev_dirty)) {
-            if (l1->invalidate(ev_addr)) ev_dirty = true;
-            if (ev_dirty) handle_writeback(ev_addr, 2);
-        }
-        l1->insert(address, is_write, ev_addr, ev_dirty);
-        return "L3 Hit";
+    if (hit_at == 0) return 0;
+
+    if (inclusion == EXCLUSIVE) {
+        bool dirty = is_write;
+        if (hit_at < n && levels[hit_at]->invalidate(address)) dirty = true;
+        fill(0, address, dirty);
+    } else {
+        for (size_t j = hit_at; j-- > 0;) fill(j, address, is_write);
     }
+    return hit_at;
+}
+
+void MemoryHierarchy::fill(size_t idx, u64 address, bool dirty) {
+    u64 ev_addr; bool ev_dirty = false;
+    if (levels[idx]->insert(address, dirty, ev_addr, ev_dirty)) evict(idx, ev_addr, ev_dirty);
+}
 
-    if (l3->insert(address, is_write, ev_addr, ev_dirty)) {
-        if (l2->invalidate(ev_addr) || l1->invalidate(ev_addr)) ev_dirty = true;
-        if (ev_dirty) handle_writeback(ev_addr, 3);
+// Disposes of a line evicted from levels[idx].
+void MemoryHierarchy::evict(size_t idx, u64 address, bool dirty) {
+    if (inclusion == EXCLUSIVE) {
+        // Victims cascade down; only a dirty one leaving the last level goes to memory.
+        if (idx + 1 < levels.size()) {
+            fill(idx + 1, address, dirty);
+            return;
+        }
+    }
+    if (inclusion == INCLUSIVE) {
+        u64 span = levels[idx]->block_size();
+        for (size_t up = 0; up < idx; up++)
+            if (levels[up]->invalidate_frame(address, span)) dirty = true;
     }
-    l2->insert(address, is_write, ev_addr, ev_dirty);
-    l1->insert(address, is_write, ev_addr, ev_dirty);
-    return "RAM Miss (Fetched to Caches)";
+    if (dirty) write_back(idx + 1, address);
+}
+
+// Dirty data reaching levels[idx]; past the last level it goes to memory.
+void MemoryHierarchy::write_back(size_t idx, u64 address) {
+    if (idx >= levels.size()) { wrote_back = true; return; }
+    if (levels[idx]->mark_dirty(address)) return;
+    fill(idx, address, true);
 }
 
-void MemoryHierarchy::handle_writeback(u64 addr, int level) {
-    if (level == 1) l2->access(addr, true);
-    else if (level == 2) l3->access(addr, true);
+void CacheModel::set_miss_classification(bool on) {
+    if (!on) classifier.reset();
+    else if (!classifier) classifier = std::make_unique<MissClassifier>(num_lines());
 }
-void CacheLevel::display_stats() const {
+
+void CacheModel::display_stats() const {
     double hr = (access_counter > 0) ? (double)hits / access_counter * 100.0 : 0.0;
 
-    std::cout << "L" << level_id << " Stats: "
+    std::cout << std::setfill(' ') << "L" << level_id << " Stats: "
               << "Hits="   << std::setw(5) << std::left << hits 
               << " | Misses=" << std::setw(5) << std::left << misses 
               << " | Hit Rate=" << std::fixed << std::setprecision(2) << std::setw(6) << std::right << hr << "%\n";
+    if (classifier)
+        std::cout << "L" << level_id << " Misses: Compulsory=" << classifier->compulsory
+                  << " | Capacity=" << classifier->capacity_misses
+                  << " | Conflict=" << classifier->conflict << "\n";
+}
+
+// Accuracy is useful / issued; coverage is the share of would-be misses that
+// a prefetch absorbed, useful / (useful + remaining demand misses).
+void CacheModel::display_prefetch_stats(const char* prefetcher) const {
+    double accuracy = pf_issued ? (double)pf_useful / pf_issued * 100.0 : 0.0;
+    double coverage = (pf_useful + misses) ? (double)pf_useful / (pf_useful + misses) * 100.0 : 0.0;
+    std::cout << "L" << level_id << " Prefetch (" << prefetcher << "): "
+              << "Issued=" << pf_issued
+              << " | Useful=" << pf_useful
+              << " | Accuracy=" << std::fixed << std::setprecision(2) << accuracy << "%"
+              << " | Coverage=" << coverage << "%"
+              << " | Evicted unused=" << pf_unused_evicted << "\n";
 }
 
 void MemoryHierarchy::display_all_stats() const {
     std::cout << "\n--- Cache Hierarchy Statistics ---\n";
-    l1->display_stats();
-    l2->display_stats();
-    l3->display_stats();
+    for (auto& level : levels) level->display_stats();
+    for (size_t i = 0; i < levels.size(); i++) {
+        if (levels[i]->prefetches_issued() == 0) continue;
+        levels[i]->display_prefetch_stats(prefetchers[i] ? prefetchers[i]->name() : "detached");
+    }
     std::cout << "----------------------------------\n";
-}
\ No newline at end of file
+}
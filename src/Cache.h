@@ -2,52 +2,80 @@
 #include <cstdint>
 #include <vector>
 #include <string>
+#include <memory>
+#include "CacheLevel.h"
+#include "Prefetcher.h"
 
-typedef uint64_t u64;
-enum ReplacementPolicy { LRU, FIFO, LFU };
+// Builds a FixedCacheLevel when the geometry is one of the specialized ones
+// (8B/8 sets/1-way, 16B/8/2, 32B/4/4, 64B/64/8), otherwise a runtime CacheLevel.
+std::unique_ptr<CacheModel> make_cache_level(int id, u64 size, u64 block_size, int assoc, ReplacementPolicy p);
 
-struct CacheLine {
-    bool valid = false;
-    bool dirty = false;
-    u64 tag = 0;
-    u64 last_access_time = 0;
-    u64 insertion_time = 0;
-    u64 freq = 0;
+struct CacheLevelSpec {
+    u64 size;
+    u64 block_size;
+    int associativity;
 };
 
-class CacheLevel {
-private:
-    int level_id;
-    u64 size;              
-    u64 block_size;         
-    int associativity;
-    u64 num_sets;
-    u64 offset_bits;
-    u64 index_bits;
-    ReplacementPolicy policy;
-    std::vector<std::vector<CacheLine>> sets;
-    u64 hits = 0, misses = 0, access_counter = 0;
-    
-public:
-    CacheLevel(int id, u64 s, u64 bs, int assoc, ReplacementPolicy p);
-    void set_policy(ReplacementPolicy p);
-    bool access(u64 address, bool is_write);
-    bool invalidate(u64 address);
-    void invalidate_frame(size_t start, size_t range);
-    bool insert(u64 address, bool is_write, u64& evicted_addr, bool& evicted_dirty);
-    void display_stats() const;
+// How a line may be duplicated across levels. INCLUSIVE fills every level
+// above the hit and back-invalidates upper copies when a level evicts;
+// NINE fills the same way but never back-invalidates; EXCLUSIVE keeps a line
+// in one level only, moving hits up into L1 and cascading victims down.
+// Exclusive mode assumes equal block sizes; with mixed sizes a victim lands
+// in the enclosing lower-level block.
+enum InclusionPolicy { INCLUSIVE, EXCLUSIVE, NINE };
+
+// Outcome of one request. hit_level is 1-based, 0 when every level missed
+// and the block came from memory; writeback is set when the request (or a
+// prefetch it triggered) pushed dirty data out of the last level.
+struct AccessResult {
+    uint8_t hit_level;
+    bool writeback;
 };
 
 class MemoryHierarchy {
 private:
-    CacheLevel* l1;
-    CacheLevel* l2;
-    CacheLevel* l3;
-    void handle_writeback(u64 address, int from_level);
-    
+    std::vector<CacheLevelSpec> specs;
+    std::vector<std::unique_ptr<CacheModel>> levels;
+    std::vector<std::unique_ptr<Prefetcher>> prefetchers;
+    ReplacementPolicy policy;
+    InclusionPolicy inclusion;
+    bool classify_misses = false;
+    std::vector<u64> proposals;                      // scratch for Prefetcher::observe
+    std::vector<std::pair<size_t, u64>> pending_prefetches;
+    bool wrote_back = false;                         // for the current request
+
+    void rebuild();
+    size_t demand(u64 address, bool is_write);
+    void fill(size_t idx, u64 address, bool dirty);
+    void evict(size_t idx, u64 address, bool dirty);
+    void write_back(size_t idx, u64 address);
+    void train(size_t idx, u64 address, bool hit);
+    void prefetch_fill(size_t idx, u64 address);
+
 public:
-    MemoryHierarchy(CacheLevel* _l1, CacheLevel* _l2, CacheLevel* _l3);
-    std::string request(u64 address, bool is_write);
+    MemoryHierarchy(const std::vector<CacheLevelSpec>& level_specs, ReplacementPolicy p = LRU,
+                    InclusionPolicy mode = INCLUSIVE);
+    AccessResult request(u64 address, bool is_write);
     void invalidate_physical_range(size_t addr, size_t size);
     void display_all_stats() const;
-};
\ No newline at end of file
+
+    // Reconfiguration rebuilds every level empty with fresh statistics.
+    // configure_level replaces level_id (1-based) or appends it below the
+    // current last level, and detaches that level's prefetcher; it throws
+    // std::invalid_argument for a bad geometry and leaves the old one in place.
+    void configure_level(int level_id, const CacheLevelSpec& spec);
+    void truncate(int depth);
+    void set_inclusion(InclusionPolicy mode);
+    void set_policy(ReplacementPolicy p);
+    size_t depth() const { return levels.size(); }
+    const CacheLevelSpec& spec(int level_id) const { return specs[level_id - 1]; }
+    InclusionPolicy inclusion_policy() const { return inclusion; }
+    ReplacementPolicy replacement_policy() const { return policy; }
+    // Three-C miss classification on every level; survives reconfiguration.
+    void set_miss_classification(bool on);
+
+    // level_id is 1-based; nullptr detaches. Prefetch lines are only printed
+    // by display_all_stats for levels that have issued prefetches.
+    void set_prefetcher(int level_id, std::unique_ptr<Prefetcher> p);
+    u64 block_size(int level_id) const { return levels[level_id - 1]->block_size(); }
+};
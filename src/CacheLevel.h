@@ -0,0 +1,460 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+#include <limits>
+#include <algorithm>
+#include <memory>
+#include "MissClassifier.h"
+
+typedef uint64_t u64;
+enum ReplacementPolicy { LRU, FIFO, LFU, PLRU, SRRIP, BRRIP, DIP };
+
+// What MemoryHierarchy drives. Runtime-sized and compile-time specialized
+// levels both implement it, so one hierarchy can mix them.
+class CacheModel {
+protected:
+    int level_id;
+    ReplacementPolicy policy;
+    u64 hits = 0, misses = 0, access_counter = 0;
+    u64 pf_issued = 0, pf_useful = 0, pf_unused_evicted = 0;
+    std::unique_ptr<MissClassifier> classifier;   // null unless enabled
+
+public:
+    CacheModel(int id, ReplacementPolicy p) : level_id(id), policy(p) {}
+    virtual ~CacheModel() = default;
+    virtual void set_policy(ReplacementPolicy p) { policy = p; }
+    virtual bool access(u64 address, bool is_write) = 0;
+    virtual bool invalidate(u64 address) = 0;
+    // Drops every line overlapping [start, start + range); true if any was dirty.
+    virtual bool invalidate_frame(size_t start, size_t range) = 0;
+    virtual bool insert(u64 address, bool is_write, u64& evicted_addr, bool& evicted_dirty) = 0;
+    // Fills a line on behalf of a prefetcher. The line counts as useful on its
+    // first demand hit and as pollution if it is evicted before that.
+    virtual bool insert_prefetch(u64 address, u64& evicted_addr, bool& evicted_dirty) = 0;
+    // Residency check that leaves statistics and replacement state untouched.
+    virtual bool probe(u64 address) const = 0;
+    // Marks a resident line dirty without counting an access; false if absent.
+    virtual bool mark_dirty(u64 address) = 0;
+    // Clears the dirty bit of every line overlapping the range without
+    // dropping them; true if any was dirty.
+    virtual bool clean_frame(size_t start, size_t range) = 0;
+    virtual u64 block_size() const = 0;
+    virtual u64 num_lines() const = 0;
+    // Starts three-C miss classification from this point on, or stops it.
+    void set_miss_classification(bool on);
+    bool classifies_misses() const { return classifier != nullptr; }
+    void display_stats() const;
+    void display_prefetch_stats(const char* prefetcher) const;
+    u64 prefetches_issued() const { return pf_issued; }
+};
+
+// Index of the first way in tags[0..n) equal to tag, or -1. Uses AVX2 or
+// SSE4.1 when the host CPU has them.
+int match_tags(const u64* tags, int n, u64 tag);
+
+// The same for a way count known at compile time: a fixed-trip loop the
+// compiler can unroll and vectorize in place, with no call through the
+// runtime-selected kernel.
+template <int N>
+inline int match_tags_fixed(const u64* tags, u64 tag) {
+    int way = -1;
+    for (int i = N - 1; i >= 0; i--) if (tags[i] == tag) way = i;
+    return way;
+}
+
+struct RuntimeGeometry {
+    u64 block_size;
+    u64 num_sets;
+    u64 offset_bits;
+    u64 index_bits;
+    int associativity;
+    static constexpr bool fixed = false;
+
+    RuntimeGeometry(u64 size, u64 bs, int assoc);
+};
+
+constexpr u64 log2_exact(u64 v) { return v <= 1 ? 0 : 1 + log2_exact(v >> 1); }
+
+template <u64 BlockSize, u64 NumSets, int Assoc>
+struct FixedGeometry {
+    static_assert(BlockSize && !(BlockSize & (BlockSize - 1)), "Block size must be power of 2");
+    static_assert(NumSets && !(NumSets & (NumSets - 1)), "Sets must be power of 2");
+    static_assert(Assoc > 0, "Associativity cannot be 0");
+
+    static constexpr u64 block_size = BlockSize;
+    static constexpr u64 num_sets = NumSets;
+    static constexpr u64 offset_bits = log2_exact(BlockSize);
+    static constexpr u64 index_bits = log2_exact(NumSets);
+    static constexpr int associativity = Assoc;
+    static constexpr bool fixed = true;
+};
+
+// Policies that rank lines by the 64-bit access/insertion/frequency counters.
+inline bool uses_counters(ReplacementPolicy p) { return p == LRU || p == FIFO || p == LFU; }
+// Policies that keep a per-set pseudo-LRU bit tree.
+inline bool uses_plru_tree(ReplacementPolicy p) { return p == PLRU || p == DIP; }
+
+// Set-associative level over a Geometry that is either RuntimeGeometry or a
+// FixedGeometry, in which case the index/tag shifts and way loop bounds are
+// constants. Line state is kept as struct-of-arrays over one flat
+// [set * associativity + way] index space, so a lookup compares a contiguous
+// run of tags. Invalid lines hold INVALID_TAG, which lets the tag compare run
+// without consulting the flags. Specialized names the policy whose victim
+// search is taken first; any other policy set at runtime is dispatched once
+// per insert.
+//
+// Replacement metadata only exists for the active policy family: the three
+// u64 counters per line for LRU/FIFO/LFU, a bit tree of associativity - 1 bits
+// per set for PLRU/DIP, and a 2-bit RRPV kept in the line's flag byte for
+// SRRIP/BRRIP. Switching between families starts the new one from a reset state.
+template <class Geometry, int Specialized = -1>
+class SetAssocCache : public CacheModel {
+protected:
+    static constexpr u64 INVALID_TAG = ~0ULL;
+    static constexpr uint8_t LINE_VALID = 1, LINE_DIRTY = 2, LINE_PREFETCHED = 16;
+    static constexpr int RRPV_SHIFT = 2;
+    static constexpr uint8_t RRPV_MASK = 3 << RRPV_SHIFT;
+    static constexpr uint8_t RRPV_MAX = 3;
+    static constexpr unsigned BIMODAL_PERIOD = 32; // 1 in 32 BIP/BRRIP fills is promoted
+    static constexpr unsigned PSEL_MAX = 1023;     // 10-bit DIP policy selector
+
+    Geometry geo;
+    std::vector<u64> tags;
+    std::vector<uint8_t> flags;
+    std::vector<u64> last_access_time;
+    std::vector<u64> insertion_time;
+    std::vector<u64> freq;
+    std::vector<u64> plru_bits;     // tree_nodes bits per set, packed
+    u64 tree_width = 1;             // associativity rounded up to a power of two
+    u64 tree_nodes = 0;
+    unsigned bimodal_tick = 0;
+    unsigned psel = (PSEL_MAX + 1) / 2;
+
+    u64 set_of(u64 address) const { return (address >> geo.offset_bits) & (geo.num_sets - 1); }
+    u64 tag_of(u64 address) const { return address >> (geo.offset_bits + geo.index_bits); }
+
+    // Calls fn(line) for every valid line overlapping [start, start + range).
+    // Within one aligned window of num_sets blocks every block shares a tag
+    // and the blocks map to consecutive sets, whose ways are contiguous in
+    // the tag array; so each window is a single vector compare of that tag
+    // against one run of tags rather than a set lookup per block.
+    template <class Fn>
+    void for_each_line_in(size_t start, size_t range, Fn fn) {
+        if (range == 0) return;
+        const u64 first = start >> geo.offset_bits;
+        const u64 last = (start + range - 1) >> geo.offset_bits;
+        for (u64 blk = first; blk <= last;) {
+            u64 window_end = std::min(last, blk | (geo.num_sets - 1));
+            u64 tag = blk >> geo.index_bits;
+            u64 base = (blk & (geo.num_sets - 1)) * geo.associativity;
+            int n = static_cast<int>((window_end - blk + 1) * geo.associativity);
+            for (int i = match_tags(tags.data() + base, n, tag); i != -1;) {
+                if (flags[base + i] & LINE_VALID) fn(base + i);
+                int next = match_tags(tags.data() + base + i + 1, n - i - 1, tag);
+                i = next == -1 ? -1 : i + 1 + next;
+            }
+            if (window_end == last) break;
+            blk = window_end + 1;
+        }
+    }
+
+    // Way holding a valid line with this tag in the set starting at base, or -1.
+    int find_way(u64 base, u64 tag) const {
+        const u64* set_tags = tags.data() + base;
+        int way = -1;
+        if constexpr (Geometry::fixed) way = match_tags_fixed<Geometry::associativity>(set_tags, tag);
+        else if (geo.associativity >= 4) way = match_tags(set_tags, geo.associativity, tag);
+        else for (int i = 0; i < geo.associativity; i++) if (set_tags[i] == tag) { way = i; break; }
+        if (tag == INVALID_TAG) {
+            // The sentinel can only collide for degenerate geometries; confirm validity.
+            while (way != -1 && !(flags[base + way] & LINE_VALID)) {
+                int next = -1;
+                for (int i = way + 1; i < geo.associativity; i++) if (set_tags[i] == tag) { next = i; break; }
+                way = next;
+            }
+        }
+        return way;
+    }
+
+    bool plru_bit(u64 set, u64 node) const {
+        u64 bit = set * tree_nodes + node;
+        return (plru_bits[bit >> 6] >> (bit & 63)) & 1;
+    }
+
+    void set_plru_bit(u64 set, u64 node, bool v) {
+        u64 bit = set * tree_nodes + node;
+        if (v) plru_bits[bit >> 6] |= 1ULL << (bit & 63);
+        else plru_bits[bit >> 6] &= ~(1ULL << (bit & 63));
+    }
+
+    // Points every node on the way's root path away from it.
+    void plru_touch(u64 set, int way) {
+        u64 node = 0, lo = 0, hi = tree_width;
+        while (hi - lo > 1) {
+            u64 mid = (lo + hi) / 2;
+            bool left = static_cast<u64>(way) < mid;
+            set_plru_bit(set, node, left);
+            node = 2 * node + (left ? 1 : 2);
+            if (left) hi = mid; else lo = mid;
+        }
+    }
+
+    // Follows the tree bits (1 = right) to the pseudo-LRU way, never stepping
+    // into the padding past a non-power-of-two associativity.
+    int plru_victim(u64 set) const {
+        u64 node = 0, lo = 0, hi = tree_width;
+        while (hi - lo > 1) {
+            u64 mid = (lo + hi) / 2;
+            bool right = plru_bit(set, node) && mid < static_cast<u64>(geo.associativity);
+            node = 2 * node + (right ? 2 : 1);
+            if (right) lo = mid; else hi = mid;
+        }
+        return static_cast<int>(lo);
+    }
+
+    int rrpv(u64 line) const { return (flags[line] & RRPV_MASK) >> RRPV_SHIFT; }
+    void set_rrpv(u64 line, int v) { flags[line] = (flags[line] & ~RRPV_MASK) | (v << RRPV_SHIFT); }
+
+    // Lowest way at the distant RRPV, ageing the whole set until one exists.
+    int rrip_victim(u64 base) {
+        int victim = 0, max_rrpv = -1;
+        for (int i = 0; i < geo.associativity; i++) {
+            int r = rrpv(base + i);
+            if (r > max_rrpv) { max_rrpv = r; victim = i; }
+        }
+        if (max_rrpv < RRPV_MAX)
+            for (int i = 0; i < geo.associativity; i++) set_rrpv(base + i, rrpv(base + i) + RRPV_MAX - max_rrpv);
+        return victim;
+    }
+
+    // DIP set dueling: a few leader sets always use LRU insertion or always
+    // BIP, misses in them steer psel, and follower sets take the winner.
+    enum DuelRole { FOLLOWER, LRU_LEADER, BIP_LEADER };
+    DuelRole duel_role(u64 set) const {
+        u64 period = geo.num_sets >= 128 ? geo.num_sets / 32 : 4;
+        u64 slot = set % period;
+        if (slot == 0) return LRU_LEADER;
+        if (slot == period - 1) return BIP_LEADER;
+        return FOLLOWER;
+    }
+
+    bool bimodal_promote() { return ++bimodal_tick % BIMODAL_PERIOD == 0; }
+
+    // First invalid way, else the policy's choice (counter policies take the
+    // lowest way holding the smallest counter).
+    template <ReplacementPolicy P>
+    int pick_victim(u64 index) {
+        u64 base = index * geo.associativity;
+        for (int i = 0; i < geo.associativity; i++)
+            if (!(flags[base + i] & LINE_VALID)) return i;
+        if constexpr (P == PLRU || P == DIP) {
+            return plru_victim(index);
+        } else if constexpr (P == SRRIP || P == BRRIP) {
+            return rrip_victim(base);
+        } else {
+            const std::vector<u64>& key = (P == LRU) ? last_access_time :
+                                          (P == FIFO) ? insertion_time : freq;
+            int victim = 0;
+            u64 min_val = std::numeric_limits<u64>::max();
+            for (int i = 0; i < geo.associativity; i++) {
+                u64 val = key[base + i];
+                if (val < min_val) { min_val = val; victim = i; }
+            }
+            return victim;
+        }
+    }
+
+    int dispatch_victim(u64 index) {
+        if (Specialized >= 0 && policy == Specialized)
+            return pick_victim<static_cast<ReplacementPolicy>(Specialized < 0 ? 0 : Specialized)>(index);
+        switch (policy) {
+        case FIFO:  return pick_victim<FIFO>(index);
+        case LFU:   return pick_victim<LFU>(index);
+        case PLRU:  return pick_victim<PLRU>(index);
+        case SRRIP: return pick_victim<SRRIP>(index);
+        case BRRIP: return pick_victim<BRRIP>(index);
+        case DIP:   return pick_victim<DIP>(index);
+        default:    return pick_victim<LRU>(index);
+        }
+    }
+
+    // Allocates the active family's metadata and drops the others'.
+    void reset_metadata(ReplacementPolicy old_policy, bool fresh) {
+        size_t lines = geo.num_sets * geo.associativity;
+        if (!uses_counters(policy)) {
+            std::vector<u64>().swap(last_access_time);
+            std::vector<u64>().swap(insertion_time);
+            std::vector<u64>().swap(freq);
+        } else if (fresh || !uses_counters(old_policy)) {
+            last_access_time.assign(lines, 0);
+            insertion_time.assign(lines, 0);
+            freq.assign(lines, 0);
+        }
+        if (!uses_plru_tree(policy)) {
+            std::vector<u64>().swap(plru_bits);
+        } else if (fresh || !uses_plru_tree(old_policy)) {
+            plru_bits.assign((geo.num_sets * tree_nodes + 63) / 64, 0);
+        }
+        if (policy == DIP && (fresh || old_policy != DIP)) psel = (PSEL_MAX + 1) / 2;
+    }
+
+    bool fill(u64 address, bool is_write, u64& ev_addr, bool& ev_dirty, bool prefetched) {
+        u64 index = set_of(address);
+        int way = dispatch_victim(index);
+        u64 line = index * geo.associativity + way;
+
+        bool evicted = false;
+        if (flags[line] & LINE_VALID) {
+            evicted = true;
+            ev_addr = (tags[line] << (geo.offset_bits + geo.index_bits)) | (index << geo.offset_bits);
+            ev_dirty = flags[line] & LINE_DIRTY;
+            if (flags[line] & LINE_PREFETCHED) pf_unused_evicted++;
+        }
+
+        tags[line] = tag_of(address);
+        flags[line] = LINE_VALID | (is_write ? LINE_DIRTY : 0) | (prefetched ? LINE_PREFETCHED : 0);
+        switch (policy) {
+        case PLRU:
+            plru_touch(index, way);
+            break;
+        case DIP: {
+            // BIP leaves the filled way where the tree points, i.e. at the LRU
+            // position, except for the occasional promoted fill.
+            DuelRole role = duel_role(index);
+            bool bip = role == BIP_LEADER || (role == FOLLOWER && psel > PSEL_MAX / 2);
+            if (!bip || bimodal_promote()) plru_touch(index, way);
+            break;
+        }
+        case SRRIP:
+            set_rrpv(line, RRPV_MAX - 1);
+            break;
+        case BRRIP:
+            set_rrpv(line, bimodal_promote() ? RRPV_MAX - 1 : RRPV_MAX);
+            break;
+        default:
+            last_access_time[line] = access_counter;
+            insertion_time[line] = access_counter;
+            freq[line] = 1;
+            break;
+        }
+        return evicted;
+    }
+
+public:
+    SetAssocCache(int id, ReplacementPolicy p, const Geometry& g) : CacheModel(id, p), geo(g) {
+        size_t lines = geo.num_sets * geo.associativity;
+        tags.assign(lines, INVALID_TAG);
+        flags.assign(lines, 0);
+        while (tree_width < static_cast<u64>(geo.associativity)) tree_width <<= 1;
+        tree_nodes = tree_width - 1;
+        reset_metadata(p, true);
+    }
+
+    void set_policy(ReplacementPolicy p) override {
+        ReplacementPolicy old_policy = policy;
+        policy = p;
+        reset_metadata(old_policy, false);
+    }
+
+    bool access(u64 address, bool is_write) override {
+        access_counter++;
+        u64 index = set_of(address);
+        u64 base = index * geo.associativity;
+        int way = find_way(base, tag_of(address));
+        if (way != -1) {
+            u64 line = base + way;
+            hits++;
+            if (flags[line] & LINE_PREFETCHED) {
+                pf_useful++;
+                flags[line] &= ~LINE_PREFETCHED;
+            }
+            if (uses_counters(policy)) {
+                last_access_time[line] = access_counter;
+                freq[line]++;
+            } else if (uses_plru_tree(policy)) {
+                plru_touch(index, way);
+            } else {
+                set_rrpv(line, 0);
+            }
+            if (is_write) flags[line] |= LINE_DIRTY;
+            if (classifier) classifier->observe(address >> geo.offset_bits, true);
+            return true;
+        }
+        misses++;
+        if (classifier) classifier->observe(address >> geo.offset_bits, false);
+        if (policy == DIP) {
+            DuelRole role = duel_role(index);
+            if (role == LRU_LEADER && psel < PSEL_MAX) psel++;
+            else if (role == BIP_LEADER && psel > 0) psel--;
+        }
+        return false;
+    }
+
+    bool insert(u64 address, bool is_write, u64& ev_addr, bool& ev_dirty) override {
+        return fill(address, is_write, ev_addr, ev_dirty, false);
+    }
+
+    bool insert_prefetch(u64 address, u64& ev_addr, bool& ev_dirty) override {
+        pf_issued++;
+        return fill(address, false, ev_addr, ev_dirty, true);
+    }
+
+    bool probe(u64 address) const override {
+        return find_way(set_of(address) * geo.associativity, tag_of(address)) != -1;
+    }
+
+    bool clean_frame(size_t start, size_t range) override {
+        bool dirty = false;
+        for_each_line_in(start, range, [&](u64 line) {
+            if (flags[line] & LINE_DIRTY) dirty = true;
+            flags[line] &= ~LINE_DIRTY;
+        });
+        return dirty;
+    }
+
+    bool mark_dirty(u64 address) override {
+        u64 base = set_of(address) * geo.associativity;
+        int way = find_way(base, tag_of(address));
+        if (way == -1) return false;
+        flags[base + way] |= LINE_DIRTY;
+        return true;
+    }
+
+    u64 block_size() const override { return geo.block_size; }
+    u64 num_lines() const override { return geo.num_sets * geo.associativity; }
+
+    bool invalidate(u64 address) override {
+        u64 base = set_of(address) * geo.associativity;
+        int way = find_way(base, tag_of(address));
+        if (way == -1) return false;
+        u64 line = base + way;
+        bool was_dirty = flags[line] & LINE_DIRTY;
+        flags[line] = 0;
+        tags[line] = INVALID_TAG;
+        return was_dirty;
+    }
+
+    bool invalidate_frame(size_t start, size_t range) override {
+        bool dirty = false;
+        for_each_line_in(start, range, [&](u64 line) {
+            if (flags[line] & LINE_DIRTY) dirty = true;
+            flags[line] = 0;
+            tags[line] = INVALID_TAG;
+        });
+        return dirty;
+    }
+};
+
+class CacheLevel : public SetAssocCache<RuntimeGeometry> {
+public:
+    CacheLevel(int id, u64 s, u64 bs, int assoc, ReplacementPolicy p)
+        : SetAssocCache(id, p, RuntimeGeometry(s, bs, assoc)) {}
+};
+
+template <u64 BlockSize, u64 NumSets, int Assoc, ReplacementPolicy Policy>
+class FixedCacheLevel : public SetAssocCache<FixedGeometry<BlockSize, NumSets, Assoc>, Policy> {
+public:
+    explicit FixedCacheLevel(int id)
+        : SetAssocCache<FixedGeometry<BlockSize, NumSets, Assoc>, Policy>(id, Policy, {}) {}
+};
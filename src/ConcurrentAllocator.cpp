@@ -0,0 +1,288 @@
+#include "ConcurrentAllocator.h"
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+
+static std::atomic<uint64_t> next_instance_id{1};
+
+ConcurrentAllocator::ConcurrentAllocator(Allocator& backend_alloc)
+    : backend(backend_alloc), instance_id(next_instance_id++) {}
+
+ConcurrentAllocator::~ConcurrentAllocator() {
+    flush_all();
+}
+
+int ConcurrentAllocator::class_of(size_t size) {
+    int cls = 0;
+    while (cls < NUM_CLASSES && class_size(cls) < size) cls++;
+    return cls < NUM_CLASSES ? cls : -1;
+}
+
+ConcurrentAllocator::ThreadCache& ConcurrentAllocator::local_cache() {
+    // One-entry memo per thread; falls back to the registry when the thread
+    // last talked to a different allocator instance.
+    thread_local uint64_t memo_owner = 0;
+    thread_local ThreadCache* memo_cache = nullptr;
+    if (memo_owner == instance_id) return *memo_cache;
+
+    std::lock_guard<std::mutex> guard(registry_lock);
+    std::thread::id self = std::this_thread::get_id();
+    ThreadCache* found = nullptr;
+    for (auto& tc : caches) {
+        if (tc->owner == self) { found = tc.get(); break; }
+    }
+    if (!found) {
+        caches.emplace_back(new ThreadCache());
+        found = caches.back().get();
+        found->owner = self;
+    }
+    memo_owner = instance_id;
+    memo_cache = found;
+    return *found;
+}
+
+bool ConcurrentAllocator::refill(ThreadCache& tc, int cls, Alloc_Algo algo) {
+    std::vector<int>& local = tc.blocks[cls];
+    {
+        CentralList& c = central[cls];
+        std::lock_guard<std::mutex> guard(c.lock);
+        size_t n = std::min(BATCH, c.blocks.size());
+        local.insert(local.end(), c.blocks.end() - n, c.blocks.end());
+        c.blocks.resize(c.blocks.size() - n);
+    }
+    if (!local.empty()) {
+        central_refills++;
+        return true;
+    }
+
+    std::lock_guard<std::mutex> guard(backend_lock);
+    for (size_t i = 0; i < BATCH; i++) {
+        int id = backend.allocate(class_size(cls), algo);
+        if (id == -1) break;
+        local.push_back(id);
+    }
+    if (local.empty()) return false;
+    backend_refills++;
+    return true;
+}
+
+void ConcurrentAllocator::flush(ThreadCache& tc, int cls, size_t count) {
+    std::vector<int>& local = tc.blocks[cls];
+    count = std::min(count, local.size());
+    CentralList& c = central[cls];
+    std::lock_guard<std::mutex> guard(c.lock);
+    c.blocks.insert(c.blocks.end(), local.end() - count, local.end());
+    local.resize(local.size() - count);
+    flushes++;
+}
+
+void ConcurrentAllocator::flush_all() {
+    std::lock_guard<std::mutex> reg(registry_lock);
+    std::lock_guard<std::mutex> guard(backend_lock);
+    for (auto& tc : caches) {
+        for (auto& blocks : tc->blocks) {
+            for (int id : blocks) backend.deallocate(id);
+            blocks.clear();
+        }
+    }
+    for (auto& c : central) {
+        std::lock_guard<std::mutex> cg(c.lock);
+        for (int id : c.blocks) backend.deallocate(id);
+        c.blocks.clear();
+    }
+}
+
+void ConcurrentAllocator::init(size_t mem_size) {
+    {
+        std::lock_guard<std::mutex> reg(registry_lock);
+        for (auto& tc : caches) {
+            for (auto& blocks : tc->blocks) blocks.clear();
+            tc->allocs = tc->frees = tc->hits = 0;
+        }
+    }
+    for (auto& c : central) c.blocks.clear();
+    for (auto& s : shards) s.live.clear();
+    large_allocs = large_frees = failed_allocs = 0;
+    central_refills = backend_refills = flushes = 0;
+
+    std::lock_guard<std::mutex> guard(backend_lock);
+    backend.init(mem_size);
+}
+
+int ConcurrentAllocator::allocate(size_t mem_size, Alloc_Algo algo) {
+    if (mem_size == 0) return -1;
+    int cls = class_of(mem_size);
+    int id = -1;
+
+    if (cls == -1) {
+        std::lock_guard<std::mutex> guard(backend_lock);
+        id = backend.allocate(mem_size, algo);
+        if (id != -1) large_allocs++;
+    } else {
+        ThreadCache& tc = local_cache();
+        std::vector<int>& local = tc.blocks[cls];
+        if (!local.empty()) tc.hits++;
+        else refill(tc, cls, algo);
+        if (!local.empty()) {
+            id = local.back();
+            local.pop_back();
+            tc.allocs++;
+        }
+    }
+
+    if (id == -1) {
+        failed_allocs++;
+        return -1;
+    }
+    Shard& s = shard_of(id);
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        s.live[id] = {cls, mem_size};
+    }
+    return id;
+}
+
+void ConcurrentAllocator::deallocate(int id) {
+    BlockInfo info;
+    Shard& s = shard_of(id);
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.live.find(id);
+        if (it == s.live.end()) return;   // unknown id or double free
+        info = it->second;
+        s.live.erase(it);
+    }
+
+    if (info.cls == -1) {
+        large_frees++;
+        std::lock_guard<std::mutex> guard(backend_lock);
+        backend.deallocate(id);
+        return;
+    }
+
+    ThreadCache& tc = local_cache();
+    tc.frees++;
+    tc.blocks[info.cls].push_back(id);
+    if (tc.blocks[info.cls].size() > CACHE_LIMIT) flush(tc, info.cls, BATCH);
+}
+
+int ConcurrentAllocator::reallocate(int id, size_t new_size, Alloc_Algo algo) {
+    if (new_size == 0) return -1;
+    Shard& s = shard_of(id);
+    {
+        std::lock_guard<std::mutex> guard(s.lock);
+        auto it = s.live.find(id);
+        if (it == s.live.end()) return -1;
+        if (it->second.cls != -1 && new_size <= class_size(it->second.cls)) {
+            it->second.req_size = new_size;
+            return id;
+        }
+    }
+
+    int new_id = allocate(new_size, algo);
+    if (new_id != -1) deallocate(id);
+    return new_id;
+}
+
+size_t ConcurrentAllocator::get_address(int id) {
+    std::lock_guard<std::mutex> guard(backend_lock);
+    return backend.get_address(id);
+}
+
+void ConcurrentAllocator::display() {
+    std::lock_guard<std::mutex> guard(backend_lock);
+    backend.display();
+}
+
+int ConcurrentAllocator::next_block_id() {
+    std::lock_guard<std::mutex> guard(backend_lock);
+    return backend.next_block_id();
+}
+
+AllocatorStats ConcurrentAllocator::snapshot() {
+    std::lock_guard<std::mutex> guard(backend_lock);
+    return backend.snapshot();
+}
+
+void ConcurrentAllocator::get_statistics() {
+    size_t cached = 0, central_blocks = 0, threads = 0;
+    size_t allocs = large_allocs, frees = large_frees, hits = 0;
+    {
+        std::lock_guard<std::mutex> reg(registry_lock);
+        threads = caches.size();
+        for (auto& tc : caches) {
+            for (auto& blocks : tc->blocks) cached += blocks.size();
+            allocs += tc->allocs;
+            frees += tc->frees;
+            hits += tc->hits;
+        }
+    }
+    for (auto& c : central) {
+        std::lock_guard<std::mutex> guard(c.lock);
+        central_blocks += c.blocks.size();
+    }
+    double hit_rate = allocs > 0 ? (double)hits / allocs * 100.0 : 0.0;
+
+    std::cout << "Threads seen      : " << threads << "\n";
+    std::cout << "Allocations       : " << allocs << " (failed " << failed_allocs << ")\n";
+    std::cout << "Frees             : " << frees << "\n";
+    std::cout << "Thread cache hits : " << std::fixed << std::setprecision(2) << hit_rate << "%\n";
+    std::cout << "Central refills   : " << central_refills << "\n";
+    std::cout << "Backend refills   : " << backend_refills << "\n";
+    std::cout << "Cache flushes     : " << flushes << "\n";
+    std::cout << "Cached blocks     : " << cached << " thread-local, " << central_blocks << " central\n";
+
+    std::lock_guard<std::mutex> guard(backend_lock);
+    backend.get_statistics();
+}
+
+void ConcurrentAllocator::benchmark(Allocator& live, int max_threads, size_t ops_per_thread) {
+    const size_t MAX_LIVE = 32;
+    std::unique_ptr<Allocator> scratch = live.make_empty();
+    if (!scratch) {
+        std::cout << "Error: This allocator cannot be benchmarked.\n";
+        return;
+    }
+    scratch->set_announce(false);
+    scratch->init(live.snapshot().total_size);
+    Allocator& backend = *scratch;
+
+    std::cout << "--- Concurrent Allocator Benchmark ---\n";
+    for (int threads = 1; threads <= max_threads; threads++) {
+        ConcurrentAllocator front(backend);
+        std::atomic<size_t> total_allocs{0};
+        std::vector<std::thread> workers;
+
+        auto start = std::chrono::steady_clock::now();
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&front, &total_allocs, ops_per_thread, t]() {
+                uint32_t rng = 0x9E3779B9u * (t + 1);
+                std::vector<int> live;
+                live.reserve(MAX_LIVE);
+                size_t allocs = 0;
+                for (size_t op = 0; op < ops_per_thread; op++) {
+                    rng ^= rng << 13; rng ^= rng >> 17; rng ^= rng << 5;
+                    if (live.size() < MAX_LIVE && (live.empty() || (rng & 1))) {
+                        int id = front.allocate(8 + (rng >> 8) % 249, Firstfit);
+                        if (id != -1) { live.push_back(id); allocs++; }
+                    } else {
+                        size_t victim = (rng >> 8) % live.size();
+                        front.deallocate(live[victim]);
+                        live[victim] = live.back();
+                        live.pop_back();
+                    }
+                }
+                for (int id : live) front.deallocate(id);
+                total_allocs += allocs;
+            });
+        }
+        for (auto& w : workers) w.join();
+        double secs = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        front.flush_all();
+
+        std::cout << "Threads=" << std::setfill(' ') << std::setw(3) << std::left << threads << std::right
+                  << " | Allocs=" << total_allocs
+                  << " | Allocs/sec=" << std::fixed << std::setprecision(0)
+                  << (secs > 0 ? total_allocs / secs : 0.0) << "\n";
+    }
+}
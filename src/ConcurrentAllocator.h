@@ -0,0 +1,84 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include "Allocator.h"
+
+// Thread-safe front end over any (single-threaded) Allocator backend.
+// Small requests are rounded to a power-of-two size class and served from a
+// per-thread cache of backend blocks; caches refill from and flush to a shared
+// central list per class in batches, and only the central list falls through
+// to the backend, which is guarded by a single mutex.
+class ConcurrentAllocator : public Allocator {
+private:
+    static constexpr int NUM_CLASSES = 8;           // 8, 16, ..., 1024 bytes
+    static constexpr size_t MIN_CLASS_SIZE = 8;
+    static constexpr size_t BATCH = 16;             // blocks moved per refill/flush
+    static constexpr size_t CACHE_LIMIT = 64;       // per thread, per class
+    static constexpr int SHARDS = 16;
+
+    struct ThreadCache {
+        std::thread::id owner;
+        std::vector<int> blocks[NUM_CLASSES];
+        size_t allocs = 0, frees = 0, hits = 0;   // owner-thread only, summed for stats
+    };
+
+    struct CentralList {
+        std::mutex lock;
+        std::vector<int> blocks;
+    };
+
+    struct BlockInfo {
+        int cls;            // -1 when the block bypassed the caches
+        size_t req_size;
+    };
+
+    struct Shard {
+        std::mutex lock;
+        std::unordered_map<int, BlockInfo> live;
+    };
+
+    Allocator& backend;
+    const uint64_t instance_id;
+    std::mutex backend_lock;
+    CentralList central[NUM_CLASSES];
+    Shard shards[SHARDS];
+    std::mutex registry_lock;
+    std::vector<std::unique_ptr<ThreadCache>> caches;
+
+    std::atomic<size_t> large_allocs{0}, large_frees{0}, failed_allocs{0};
+    std::atomic<size_t> central_refills{0}, backend_refills{0}, flushes{0};
+
+    static int class_of(size_t size);
+    static size_t class_size(int cls) { return MIN_CLASS_SIZE << cls; }
+    ThreadCache& local_cache();
+    Shard& shard_of(int id) { return shards[static_cast<unsigned>(id) % SHARDS]; }
+    bool refill(ThreadCache& tc, int cls, Alloc_Algo algo);
+    void flush(ThreadCache& tc, int cls, size_t count);
+
+public:
+    explicit ConcurrentAllocator(Allocator& backend_alloc);
+    ~ConcurrentAllocator();
+
+    // Not thread-safe: call only while no other thread uses the allocator.
+    void init(size_t mem_size) override;
+    void flush_all();
+
+    int allocate(size_t mem_size, Alloc_Algo algo) override;
+    void deallocate(int id) override;
+    size_t get_address(int id) override;
+    void display() override;
+    void get_statistics() override;
+    AllocatorStats snapshot() override;
+    int next_block_id() override;
+    int reallocate(int id, size_t new_size, Alloc_Algo algo = Firstfit) override; // in place while it fits the block's class
+
+    // Multi-threaded stress run for 1..max_threads threads, reporting
+    // allocations per second. It runs on a scratch backend of the same kind
+    // and size as `live`, so live's ids and statistics are left untouched.
+    static void benchmark(Allocator& live, int max_threads, size_t ops_per_thread);
+};
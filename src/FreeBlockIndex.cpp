@@ -0,0 +1,126 @@
+#include "FreeBlockIndex.h"
+#include "MemoryAllocator.h"
+
+bool FreeBlockIndex::SizeOrder::operator()(const Mem_Block* a, const Mem_Block* b) const {
+    if (a->mem_size != b->mem_size) return a->mem_size < b->mem_size;
+    return a->start_address < b->start_address;
+}
+
+unsigned FreeBlockIndex::next_priority() {
+    // xorshift32, only needs to be "random enough" to keep the treap balanced
+    rng_state ^= rng_state << 13;
+    rng_state ^= rng_state >> 17;
+    rng_state ^= rng_state << 5;
+    return rng_state;
+}
+
+size_t FreeBlockIndex::subtree_max(Mem_Block* n) {
+    return n ? n->max_free : 0;
+}
+
+void FreeBlockIndex::update(Mem_Block* n) {
+    n->max_free = std::max(n->mem_size, std::max(subtree_max(n->left), subtree_max(n->right)));
+}
+
+void FreeBlockIndex::split(Mem_Block* n, size_t key, Mem_Block*& l, Mem_Block*& r) {
+    if (!n) { l = r = nullptr; return; }
+    if (n->start_address < key) {
+        split(n->right, key, n->right, r);
+        l = n;
+    } else {
+        split(n->left, key, l, n->left);
+        r = n;
+    }
+    update(n);
+}
+
+Mem_Block* FreeBlockIndex::merge(Mem_Block* l, Mem_Block* r) {
+    if (!l) return r;
+    if (!r) return l;
+    if (l->priority > r->priority) {
+        l->right = merge(l->right, r);
+        update(l);
+        return l;
+    }
+    r->left = merge(l, r->left);
+    update(r);
+    return r;
+}
+
+void FreeBlockIndex::clear() {
+    root = nullptr;
+    by_size.clear();
+    free_bytes = 0;
+    std::fill(std::begin(histogram), std::end(histogram), 0);
+}
+
+size_t FreeBlockIndex::largest() const {
+    return by_size.empty() ? 0 : (*by_size.rbegin())->mem_size;
+}
+
+void FreeBlockIndex::fill_stats(AllocatorStats& s) const {
+    s.free = free_bytes;
+    s.largest_free = largest();
+    s.free_blocks = by_size.size();
+    std::copy(std::begin(histogram), std::end(histogram), s.free_histogram);
+}
+
+void FreeBlockIndex::insert(Mem_Block* blk) {
+    blk->left = blk->right = nullptr;
+    blk->priority = next_priority();
+    blk->max_free = blk->mem_size;
+
+    Mem_Block *l, *r;
+    split(root, blk->start_address, l, r);
+    root = merge(merge(l, blk), r);
+    by_size.insert(blk);
+    free_bytes += blk->mem_size;
+    histogram[size_bucket(blk->mem_size)]++;
+}
+
+void FreeBlockIndex::erase(Mem_Block* blk) {
+    by_size.erase(blk);
+    free_bytes -= blk->mem_size;
+    histogram[size_bucket(blk->mem_size)]--;
+
+    Mem_Block *l, *mid, *r;
+    split(root, blk->start_address, l, r);
+    split(r, blk->start_address + 1, mid, r);
+    root = merge(l, r);
+    blk->left = blk->right = nullptr;
+}
+
+Mem_Block* FreeBlockIndex::lowest() const {
+    Mem_Block* n = root;
+    while (n && n->left) n = n->left;
+    return n;
+}
+
+Mem_Block* FreeBlockIndex::find(size_t mem_size, Alloc_Algo algo) const {
+    if (by_size.empty()) return nullptr;
+
+    if (algo == Bestfit) {
+        // Smallest fitting size; ties go to the lowest address, like the list walk.
+        Mem_Block key(0, mem_size);
+        auto it = by_size.lower_bound(&key);
+        return it == by_size.end() ? nullptr : *it;
+    }
+
+    if (algo == Worstfit) {
+        // Largest size; ties go to the lowest address.
+        size_t largest = (*by_size.rbegin())->mem_size;
+        if (largest < mem_size) return nullptr;
+        Mem_Block key(0, largest);
+        return *by_size.lower_bound(&key);
+    }
+
+    // First fit: lowest address whose size fits, found by following max_free.
+    Mem_Block* n = root;
+    if (subtree_max(n) < mem_size) return nullptr;
+    while (n) {
+        if (subtree_max(n->left) >= mem_size) n = n->left;
+        else if (n->mem_size >= mem_size) return n;
+        else n = n->right;
+    }
+    return nullptr;
+}
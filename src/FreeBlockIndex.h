@@ -0,0 +1,40 @@
+#pragma once
+#include <cstddef>
+#include <set>
+#include "Allocator.h"
+
+struct Mem_Block;
+
+// Index over the free Mem_Blocks of a MemoryAllocator.
+// Address order lives in an intrusive treap (links stored in Mem_Block) augmented
+// with the largest free size per subtree, so first fit is a single descent.
+// Size order lives in a set keyed by (size, address) for best/worst fit.
+class FreeBlockIndex {
+private:
+    struct SizeOrder {
+        bool operator()(const Mem_Block* a, const Mem_Block* b) const;
+    };
+
+    Mem_Block* root = nullptr;
+    std::set<Mem_Block*, SizeOrder> by_size;
+    unsigned rng_state = 2463534242u;
+    size_t free_bytes = 0;
+    size_t histogram[64] = {};
+
+    unsigned next_priority();
+    static size_t subtree_max(Mem_Block* n);
+    static void update(Mem_Block* n);
+    static void split(Mem_Block* n, size_t key, Mem_Block*& l, Mem_Block*& r); // l: < key, r: >= key
+    static Mem_Block* merge(Mem_Block* l, Mem_Block* r);
+
+public:
+    void clear();
+    void insert(Mem_Block* blk);  // blk must be free and not already indexed
+    void erase(Mem_Block* blk);   // call before changing blk's size or address
+    Mem_Block* find(size_t mem_size, Alloc_Algo algo) const;
+    Mem_Block* lowest() const;    // free block with the lowest address
+    size_t size() const { return by_size.size(); }
+    size_t total_free() const { return free_bytes; }
+    size_t largest() const;
+    void fill_stats(AllocatorStats& s) const;
+};
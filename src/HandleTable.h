@@ -0,0 +1,81 @@
+#pragma once
+#include <cstddef>
+#include <vector>
+
+// Dense id -> value table for allocator block ids.
+// Ids are issued sequentially from 1 and never reused until clear(), so an id
+// indexes the slot array directly and a freed slot stays dead: lookups of
+// stale ids and double frees simply miss. The array is a sliding window over
+// the id space; once the oldest ids are all dead the window drops them, so
+// memory tracks the span of live ids rather than every id ever issued.
+template <typename T>
+class HandleTable {
+private:
+    struct Slot {
+        T value;
+        bool live;
+    };
+
+    std::vector<Slot> slots;
+    int first_id = 1;       // id of slots[0]
+    size_t head = 0;        // index of the oldest slot that may still be live
+    size_t live_count = 0;
+
+    Slot* slot_of(int id) {
+        if (id < first_id) return nullptr;
+        size_t idx = static_cast<size_t>(id - first_id);
+        if (idx >= slots.size() || !slots[idx].live) return nullptr;
+        return &slots[idx];
+    }
+
+    void trim() {
+        while (head < slots.size() && !slots[head].live) head++;
+        if (head >= 64 && head * 2 >= slots.size()) {
+            slots.erase(slots.begin(), slots.begin() + head);
+            first_id += static_cast<int>(head);
+            head = 0;
+        }
+    }
+
+public:
+    int next_id() const { return first_id + static_cast<int>(slots.size()); }
+
+    int insert(const T& value) {
+        int id = next_id();
+        slots.push_back({value, true});
+        live_count++;
+        return id;
+    }
+
+    T* find(int id) {
+        Slot* s = slot_of(id);
+        return s ? &s->value : nullptr;
+    }
+
+    // Removes id, copying its value to *out. Returns false for unknown ids.
+    bool erase(int id, T* out = nullptr) {
+        Slot* s = slot_of(id);
+        if (!s) return false;
+        if (out) *out = s->value;
+        s->live = false;
+        live_count--;
+        trim();
+        return true;
+    }
+
+    template <typename F>
+    void for_each(F fn) {
+        for (size_t i = head; i < slots.size(); i++) {
+            if (slots[i].live) fn(first_id + static_cast<int>(i), slots[i].value);
+        }
+    }
+
+    void clear() {
+        slots.clear();
+        first_id = 1;
+        head = 0;
+        live_count = 0;
+    }
+
+    size_t size() const { return live_count; }
+};
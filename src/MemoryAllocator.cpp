@@ -1,43 +1,34 @@
 #include "MemoryAllocator.h"
+#include "Cache.h"
 #include <iostream>
 #include <limits>
 #include <iomanip>
-MemoryAllocator::MemoryAllocator() : total_size(0), head(nullptr), next_Id(1) {}
-MemoryAllocator::~MemoryAllocator() {
-    Mem_Block* curr = head;
-    while (curr) {
-        Mem_Block* temp = curr;
-        curr = curr->next;
-        delete temp;
-    }
-    head = nullptr;
-}
+MemoryAllocator::MemoryAllocator() : total_size(0), head(nullptr) {}
+MemoryAllocator::~MemoryAllocator() {}
 size_t MemoryAllocator::get_address(int id) {
-    if (id_map.find(id) != id_map.end()) {
-        return id_map[id]->start_address;
+    Mem_Block** blk = id_map.find(id);
+    if (blk) {
+        return (*blk)->start_address;
     }
     return 0; 
 }
 void MemoryAllocator::init(size_t mem_size) {
-    if (head) {
-        Mem_Block* curr = head;
-        while (curr) {
-            Mem_Block* temp = curr;
-            curr = curr->next;
-            delete temp;
-        }
-        head = nullptr;
-    }
+    nodes.reset();
+    head = nullptr;
     
     id_map.clear();
+    free_index.clear();
+    internal_frag = 0;
+    compaction_bytes_moved = compaction_blocks_moved = 0;
+    realloc_calls = realloc_in_place = 0;
     
     if (mem_size == 0) return;
 
     total_size = mem_size;
-    next_Id = 1;
     // Create the initial giant free block
-    head = new Mem_Block(0, mem_size, 0, true, 0);
-    std::cout << "[System] Linear Memory Initialized: " << mem_size << " bytes.\n";
+    head = nodes.create(size_t(0), mem_size, 0, true, 0);
+    free_index.insert(head);
+    if (announce) std::cout << "[System] Linear Memory Initialized: " << mem_size << " bytes.\n";
 }
 
 int MemoryAllocator::allocate(size_t mem_size, Alloc_Algo algo) {
@@ -46,63 +37,316 @@ int MemoryAllocator::allocate(size_t mem_size, Alloc_Algo algo) {
 
    // size_t aligned_size = (mem_size + (ALIGNMENT - 1)) & ~(ALIGNMENT - 1);
    size_t aligned_size=mem_size;
-    Mem_Block* best = nullptr;
-    Mem_Block* curr = head;
-
-    while (curr) {
-        if (curr->is_free && curr->mem_size >= aligned_size) {
-            if (algo == Firstfit) { best = curr; break; }
-            if (algo == Bestfit) { if (!best || curr->mem_size < best->mem_size) best = curr; }
-            else if (algo == Worstfit) { if (!best || curr->mem_size > best->mem_size) best = curr; }
-        }
-        curr = curr->next;
-    }
+    Mem_Block* best = free_index.find(aligned_size, algo);
 
     if (!best) return -1;
+    free_index.erase(best);
+    return place(best, mem_size);
+}
 
-    if (best->mem_size > aligned_size) {
-        Mem_Block* new_free = new Mem_Block(best->start_address + aligned_size, 
-                                            best->mem_size - aligned_size, 0, true, 0);
+// Turns the (already unindexed) free block `best` into a used block of
+// mem_size bytes, returning the tail to the free index.
+int MemoryAllocator::place(Mem_Block* best, size_t mem_size) {
+    if (best->mem_size > mem_size) {
+        Mem_Block* new_free = nodes.create(best->start_address + mem_size, 
+                                            best->mem_size - mem_size, 0, true, 0);
         new_free->next = best->next;
         new_free->prev = best;
         if (best->next) best->next->prev = new_free;
         best->next = new_free;
-        best->mem_size = aligned_size;
+        best->mem_size = mem_size;
+        free_index.insert(new_free);
     }
 
     best->is_free = false;
-    best->Id = next_Id++;
+    best->Id = id_map.insert(best);
     best->req_size = mem_size; 
-    id_map[best->Id] = best;
+    internal_frag += best->mem_size - mem_size;
     
     successful_allocations++; // Track success
     return best->Id;
-}void MemoryAllocator::deallocate(int Id) {
-    if (id_map.find(Id) == id_map.end()) return;
+}
+
+int MemoryAllocator::allocate_aligned(size_t mem_size, size_t align, Alloc_Algo algo) {
+    if (align == 0 || (align & (align - 1)) != 0) return -1;
+    if (align == 1) return allocate(mem_size, algo);
+    if (mem_size == 0) return -1;
+    total_alloc_attempts++;
+
+    auto aligned_start = [align](size_t addr) { return (addr + align - 1) & ~(align - 1); };
+
+    // Any block of mem_size + align - 1 bytes fits whatever its start, so the
+    // strategy applies as usual; only if none exists look for a lucky exact fit.
+    Mem_Block* best = free_index.find(mem_size + align - 1, algo);
+    for (Mem_Block* curr = head; !best && curr; curr = curr->next) {
+        if (curr->is_free && aligned_start(curr->start_address) + mem_size <= curr->start_address + curr->mem_size) {
+            best = curr;
+        }
+    }
+    if (!best) return -1;
+    free_index.erase(best);
+
+    size_t pad = aligned_start(best->start_address) - best->start_address;
+    if (pad > 0) {
+        // The leading pad stays behind as its own free block.
+        Mem_Block* blk = nodes.create(best->start_address + pad, best->mem_size - pad, 0, true, 0);
+        blk->next = best->next;
+        blk->prev = best;
+        if (best->next) best->next->prev = blk;
+        best->next = blk;
+        best->mem_size = pad;
+        free_index.insert(best);
+        best = blk;
+    }
+    return place(best, mem_size);
+}
+
+// Gives everything past the first `keep` bytes of a used block back as free space.
+void MemoryAllocator::free_tail(Mem_Block* blk, size_t keep) {
+    Mem_Block* tail = nodes.create(blk->start_address + keep, blk->mem_size - keep, 0, true, 0);
+    blk->mem_size = keep;
+    tail->prev = blk;
+    tail->next = blk->next;
+    if (blk->next) blk->next->prev = tail;
+    blk->next = tail;
+
+    Mem_Block* after = tail->next;
+    if (after && after->is_free) {
+        free_index.erase(after);
+        tail->mem_size += after->mem_size;
+        tail->next = after->next;
+        if (after->next) after->next->prev = tail;
+        nodes.destroy(after);
+    }
+    free_index.insert(tail);
+}
+
+int MemoryAllocator::reallocate(int Id, size_t new_size, Alloc_Algo algo) {
+    Mem_Block** slot = id_map.find(Id);
+    if (!slot || new_size == 0) return -1;
+    Mem_Block* blk = *slot;
+    realloc_calls++;
+
+    Mem_Block* next = blk->next;
+    bool fits = new_size <= blk->mem_size;
+    bool grows_into_next = !fits && next && next->is_free && blk->mem_size + next->mem_size >= new_size;
 
-    Mem_Block* curr = id_map[Id];
+    if (fits || grows_into_next) {
+        internal_frag -= blk->mem_size - blk->req_size;
+        if (fits) {
+            if (new_size < blk->mem_size) free_tail(blk, new_size);
+        } else {
+            size_t need = new_size - blk->mem_size;
+            free_index.erase(next);
+            if (next->mem_size > need) {
+                next->start_address += need;
+                next->mem_size -= need;
+                free_index.insert(next);
+            } else {
+                blk->next = next->next;
+                if (next->next) next->next->prev = blk;
+                nodes.destroy(next);
+            }
+            blk->mem_size = new_size;
+        }
+        blk->req_size = new_size;
+        internal_frag += blk->mem_size - blk->req_size;
+        realloc_in_place++;
+        return Id;
+    }
+
+    int new_id = allocate(new_size, algo);
+    if (new_id != -1) deallocate(Id);
+    return new_id;
+}
+
+void MemoryAllocator::deallocate(int Id) {
+    Mem_Block* curr;
+    if (!id_map.erase(Id, &curr)) return;
+
+    internal_frag -= curr->mem_size - curr->req_size;
     curr->is_free = true;
     curr->Id = 0;
     curr->req_size = 0;
-    id_map.erase(Id);
 
     // Coalesce with next block if it is free
     if (curr->next && curr->next->is_free) {
         Mem_Block* next_block = curr->next;
+        free_index.erase(next_block);
         curr->mem_size += next_block->mem_size;
         curr->next = next_block->next;
         if (next_block->next) next_block->next->prev = curr;
-        delete next_block;
+        nodes.destroy(next_block);
     }
 
     // Coalesce with previous block if it is free
     if (curr->prev && curr->prev->is_free) {
         Mem_Block* prev_block = curr->prev;
+        free_index.erase(prev_block);
         prev_block->mem_size += curr->mem_size;
         prev_block->next = curr->next;
         if (curr->next) curr->next->prev = prev_block;
-        delete curr;
+        nodes.destroy(curr);
+        curr = prev_block;
     }
+
+    free_index.insert(curr);
+}
+
+// Carves consecutive results out of one free block while that block's remainder
+// is still the one allocate() would pick, so the remainder is not re-indexed
+// after every split. Placement matches calling allocate() once per size.
+size_t MemoryAllocator::allocate_batch(const std::vector<size_t>& sizes, Alloc_Algo algo, std::vector<int>& ids) {
+    ids.assign(sizes.size(), -1);
+    size_t done = 0;
+    Mem_Block* cur = nullptr;     // free block being carved, not in free_index
+    size_t cur_query = 0;         // size that cur was selected for
+
+    for (size_t i = 0; i < sizes.size(); i++) {
+        size_t mem_size = sizes[i];
+        if (mem_size == 0) continue;
+        total_alloc_attempts++;
+
+        if (cur) {
+            bool keep = cur->mem_size >= mem_size;
+            // First fit: nothing below cur fitted cur_query, so nothing fits a larger request.
+            if (keep && !(algo == Firstfit && mem_size >= cur_query)) {
+                Mem_Block* rival = free_index.find(mem_size, algo);
+                if (rival) {
+                    if (algo == Firstfit) keep = cur->start_address < rival->start_address;
+                    else if (algo == Bestfit) keep = cur->mem_size < rival->mem_size ||
+                        (cur->mem_size == rival->mem_size && cur->start_address < rival->start_address);
+                    else keep = cur->mem_size > rival->mem_size ||
+                        (cur->mem_size == rival->mem_size && cur->start_address < rival->start_address);
+                }
+            }
+            if (!keep) {
+                free_index.insert(cur);
+                cur = nullptr;
+            }
+        }
+        if (!cur) {
+            cur = free_index.find(mem_size, algo);
+            if (!cur) continue;
+            free_index.erase(cur);
+            cur_query = mem_size;
+        }
+
+        Mem_Block* blk = cur;
+        cur = nullptr;
+        if (blk->mem_size > mem_size) {
+            Mem_Block* rest = nodes.create(blk->start_address + mem_size, blk->mem_size - mem_size, 0, true, 0);
+            rest->next = blk->next;
+            rest->prev = blk;
+            if (blk->next) blk->next->prev = rest;
+            blk->next = rest;
+            blk->mem_size = mem_size;
+            cur = rest;
+        }
+
+        blk->is_free = false;
+        blk->Id = id_map.insert(blk);
+        blk->req_size = mem_size;
+        internal_frag += blk->mem_size - mem_size;
+        ids[i] = blk->Id;
+        successful_allocations++;
+        done++;
+    }
+
+    if (cur) free_index.insert(cur);
+    return done;
+}
+
+// Marks every block in the range free first and then coalesces each free run
+// once, instead of merging and re-indexing after every single free.
+void MemoryAllocator::deallocate_range(int first_id, int last_id) {
+    const int PENDING = -1, ABSORBED = -2;   // Id markers used only inside this call
+    std::vector<Mem_Block*> freed, absorbed;
+
+    last_id = std::min(last_id, id_map.next_id() - 1);   // also keeps id++ from overflowing
+    for (int id = std::max(first_id, 1); id <= last_id; id++) {
+        Mem_Block* blk;
+        if (!id_map.erase(id, &blk)) continue;
+        internal_frag -= blk->mem_size - blk->req_size;
+        blk->is_free = true;
+        blk->Id = PENDING;
+        blk->req_size = 0;
+        freed.push_back(blk);
+    }
+
+    for (Mem_Block* blk : freed) {
+        if (blk->Id != PENDING) continue;
+
+        Mem_Block* start = blk;
+        while (start->prev && start->prev->is_free) start = start->prev;
+        if (start->Id == 0) free_index.erase(start);
+
+        while (start->next && start->next->is_free) {
+            Mem_Block* n = start->next;
+            if (n->Id == 0) free_index.erase(n);
+            start->mem_size += n->mem_size;
+            start->next = n->next;
+            if (n->next) n->next->prev = start;
+            n->Id = ABSORBED;
+            absorbed.push_back(n);
+        }
+        start->Id = 0;
+        free_index.insert(start);
+    }
+
+    for (Mem_Block* n : absorbed) nodes.destroy(n);
+}
+
+size_t MemoryAllocator::compact(size_t byte_budget, MemoryHierarchy* cache) {
+    size_t moved = 0;
+
+    while (true) {
+        Mem_Block* hole = free_index.lowest();
+        if (!hole || !hole->next) break;          // no hole, or only free space at the end
+        Mem_Block* blk = hole->next;              // used, since free neighbours are coalesced
+        if (moved > 0 && moved + blk->mem_size > byte_budget) break;
+
+        free_index.erase(hole);
+
+        // Swap the two nodes in the list: blk slides down, the hole moves up.
+        Mem_Block* before = hole->prev;
+        Mem_Block* after = blk->next;
+        if (before) before->next = blk;
+        else head = blk;
+        blk->prev = before;
+        blk->next = hole;
+        hole->prev = blk;
+        hole->next = after;
+        if (after) after->prev = hole;
+
+        size_t old_start = blk->start_address;
+        blk->start_address = hole->start_address;
+        hole->start_address = blk->start_address + blk->mem_size;
+
+        // Old and new ranges are contiguous: [new start, old end).
+        if (cache) cache->invalidate_physical_range(blk->start_address, old_start + blk->mem_size - blk->start_address);
+
+        // The hole may now touch the next free block.
+        if (after && after->is_free) {
+            free_index.erase(after);
+            hole->mem_size += after->mem_size;
+            hole->next = after->next;
+            if (after->next) after->next->prev = hole;
+            nodes.destroy(after);
+        }
+        free_index.insert(hole);
+
+        moved += blk->mem_size;
+        compaction_blocks_moved++;
+    }
+
+    compaction_bytes_moved += moved;
+    return moved;
+}
+
+bool MemoryAllocator::is_compacted() const {
+    Mem_Block* hole = free_index.lowest();
+    return !hole || !hole->next;
 }
 
 void MemoryAllocator::display() {
@@ -116,32 +360,37 @@ void MemoryAllocator::display() {
     }
 }
 
-void MemoryAllocator::get_statistics() {
-    size_t total_free = 0, used = 0, internal_frag = 0;
-    size_t largest_free_block = 0; 
+AllocatorStats MemoryAllocator::snapshot() {
+    AllocatorStats s;
+    s.total_size = total_size;
+    free_index.fill_stats(s);
+    s.used = head ? total_size - s.free : 0;
+    s.internal_frag = internal_frag;
+    return s;
+}
 
-    Mem_Block* curr = head;
-    while (curr) {
-        if (curr->is_free) {
-            total_free += curr->mem_size;
-            if (curr->mem_size > largest_free_block) largest_free_block = curr->mem_size;
-        } else {
-            used += curr->mem_size;
-            internal_frag += (curr->mem_size - curr->req_size);
-        }
-        curr = curr->next;
-    }
+void MemoryAllocator::get_statistics() {
+    AllocatorStats s = snapshot();
     
-    double ext_frag_perc = (total_free > 0) 
-        ? (double)(total_free - largest_free_block) / total_free * 100.0 
+    double ext_frag_perc = (s.free > 0) 
+        ? (double)(s.free - s.largest_free) / s.free * 100.0 
         : 0.0;
-    double utilization = total_size > 0 ? (double)used / total_size * 100.0 : 0;
+    double utilization = total_size > 0 ? (double)s.used / total_size * 100.0 : 0;
     double success_rate = total_alloc_attempts > 0 ? (double)successful_allocations / total_alloc_attempts * 100.0 : 0;
 
     std::cout << "Total memory: " << total_size << "\n";
-    std::cout << "Used memory: " << used << "\n";
-    std::cout << "Internal fragmentation: " << internal_frag << "\n";
+    std::cout << "Used memory: " << s.used << "\n";
+    std::cout << "Internal fragmentation: " << s.internal_frag << "\n";
     std::cout << "External fragmentation: " << std::fixed << std::setprecision(0) << ext_frag_perc << "%\n";
     std::cout << "Allocation success rate: " << success_rate << "%\n";
     std::cout << "Memory utilization: " << utilization << "%\n";
+    print_free_histogram(s);
+    if (realloc_calls > 0) {
+        std::cout << "Realloc in-place rate: " << (double)realloc_in_place / realloc_calls * 100.0 << "% ("
+                  << realloc_in_place << "/" << realloc_calls << ")\n";
+    }
+    if (compaction_blocks_moved > 0) {
+        std::cout << "Compaction: " << compaction_bytes_moved << " bytes moved in "
+                  << compaction_blocks_moved << " block(s)\n";
+    }
 }
\ No newline at end of file
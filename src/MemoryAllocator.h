@@ -1,5 +1,10 @@
 #pragma once
 #include "Allocator.h"
+#include "FreeBlockIndex.h"
+#include "NodePool.h"
+#include "HandleTable.h"
+
+class MemoryHierarchy;
 
 struct Mem_Block {
     int Id;
@@ -9,27 +14,56 @@ struct Mem_Block {
     bool is_free;
     Mem_Block* next;
     Mem_Block* prev;
+    // FreeBlockIndex links, only meaningful while the block is free.
+    Mem_Block* left;
+    Mem_Block* right;
+    unsigned priority;
+    size_t max_free;
 
     Mem_Block(size_t addr, size_t sz, int id = 0, bool free = true, size_t req = 0)
-        : Id(id), start_address(addr), mem_size(sz), req_size(req), is_free(free), next(nullptr), prev(nullptr) {}
+        : Id(id), start_address(addr), mem_size(sz), req_size(req), is_free(free), next(nullptr), prev(nullptr),
+          left(nullptr), right(nullptr), priority(0), max_free(0) {}
 };
 
 class MemoryAllocator : public Allocator {
 private:
     size_t total_size;
     Mem_Block* head;
-    int next_Id;
-    std::unordered_map<int, Mem_Block*> id_map;
+    NodePool<Mem_Block> nodes;
+    HandleTable<Mem_Block*> id_map;
+    FreeBlockIndex free_index;
+    size_t internal_frag = 0;
     size_t total_alloc_attempts = 0;
     size_t successful_allocations = 0;
+    size_t compaction_bytes_moved = 0;
+    size_t compaction_blocks_moved = 0;
+    size_t realloc_calls = 0;
+    size_t realloc_in_place = 0;
+
+    int place(Mem_Block* best, size_t mem_size);
+    void free_tail(Mem_Block* blk, size_t keep);
 
 public:
     MemoryAllocator();
     ~MemoryAllocator();
     void init(size_t mem_size) override;
+    std::unique_ptr<Allocator> make_empty() const override { return std::make_unique<MemoryAllocator>(); }
+    int next_block_id() override { return id_map.next_id(); }
     int allocate(size_t mem_size, Alloc_Algo algo) override;
     void deallocate(int Id) override;
     size_t get_address(int Id) override;
     void display() override;
     void get_statistics() override;
+    AllocatorStats snapshot() override;
+    size_t allocate_batch(const std::vector<size_t>& sizes, Alloc_Algo algo, std::vector<int>& ids) override;
+    void deallocate_range(int first_id, int last_id) override;
+    int allocate_aligned(size_t mem_size, size_t align, Alloc_Algo algo) override;
+    int reallocate(int Id, size_t new_size, Alloc_Algo algo = Firstfit) override; // grows into a free next block when it can
+
+    // Slides used blocks down into the lowest holes until about byte_budget
+    // bytes have been moved (at least one block per call, so repeated calls
+    // always make progress). Ids stay valid; moved ranges are invalidated in
+    // `cache` if given. Returns the bytes moved by this call.
+    size_t compact(size_t byte_budget, MemoryHierarchy* cache = nullptr);
+    bool is_compacted() const;
 };
\ No newline at end of file
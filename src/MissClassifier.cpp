@@ -0,0 +1,76 @@
+#include "MissClassifier.h"
+
+MissClassifier::MissClassifier(size_t capacity) : nodes(capacity ? capacity : 1) {
+    // At most half full, so probe runs stay short.
+    size_t n = 2;
+    slot_shift = 63;
+    while (n < 2 * nodes.size()) { n <<= 1; slot_shift--; }
+    slots.assign(n, Slot{0, NIL});
+    slot_mask = n - 1;
+}
+
+size_t MissClassifier::find_slot(u64 block) const {
+    for (size_t i = home(block);; i = (i + 1) & slot_mask)
+        if (slots[i].node == NIL || slots[i].block == block) return i;
+}
+
+// Backward-shift deletion: pull later members of the probe run into the hole
+// so lookups never need tombstones.
+void MissClassifier::erase_slot(size_t slot) {
+    size_t hole = slot;
+    for (size_t i = (slot + 1) & slot_mask; slots[i].node != NIL; i = (i + 1) & slot_mask) {
+        size_t h = home(slots[i].block);
+        if (((i - h) & slot_mask) >= ((i - hole) & slot_mask)) {
+            slots[hole] = slots[i];
+            hole = i;
+        }
+    }
+    slots[hole].node = NIL;
+}
+
+void MissClassifier::unlink(uint32_t n) {
+    Node& node = nodes[n];
+    if (node.prev != NIL) nodes[node.prev].next = node.next; else head = node.next;
+    if (node.next != NIL) nodes[node.next].prev = node.prev; else tail = node.prev;
+}
+
+void MissClassifier::push_front(uint32_t n) {
+    nodes[n].prev = NIL;
+    nodes[n].next = head;
+    if (head != NIL) nodes[head].prev = n; else tail = n;
+    head = n;
+}
+
+// True on a shadow hit. A miss installs the block, recycling the LRU node
+// once the pool is full.
+bool MissClassifier::shadow_access(u64 block) {
+    size_t slot = find_slot(block);
+    if (slots[slot].node != NIL) {
+        uint32_t n = slots[slot].node;
+        if (n != head) { unlink(n); push_front(n); }
+        return true;
+    }
+
+    uint32_t n;
+    if (used < nodes.size()) {
+        n = static_cast<uint32_t>(used++);
+    } else {
+        n = tail;
+        unlink(n);
+        erase_slot(find_slot(nodes[n].block));
+        slot = find_slot(block);   // the shift may have moved the empty slot
+    }
+    nodes[n].block = block;
+    slots[slot] = Slot{block, n};
+    push_front(n);
+    return false;
+}
+
+void MissClassifier::observe(u64 block, bool hit) {
+    bool first = seen.insert(block).second;
+    bool shadow_hit = shadow_access(block);
+    if (hit) return;
+    if (first) compulsory++;
+    else if (!shadow_hit) capacity_misses++;
+    else conflict++;
+}
@@ -0,0 +1,53 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <unordered_set>
+#include <vector>
+
+typedef uint64_t u64;
+
+// Splits one level's demand misses into the three Cs. A block never seen
+// before is compulsory; otherwise the access is replayed against a fully
+// associative LRU cache of the same number of lines, and a miss there is
+// capacity while a hit there (the real level missed anyway) is conflict.
+//
+// The shadow is a hashed LRU: an open-addressing table from block to node
+// and an intrusive recency list over a fixed node pool, so an observation is
+// O(1) and allocates nothing once the first-touch set has seen the block.
+class MissClassifier {
+private:
+    static constexpr uint32_t NIL = ~0u;
+
+    struct Node {
+        u64 block;
+        uint32_t prev, next;
+    };
+
+    std::unordered_set<u64> seen;
+    std::vector<Node> nodes;        // pool of `capacity` entries
+    // The key sits beside the node index so probing never touches the pool.
+    struct Slot {
+        u64 block;
+        uint32_t node;              // NIL when empty
+    };
+
+    std::vector<Slot> slots;
+    u64 slot_mask;
+    unsigned slot_shift;            // 64 - log2(slots.size())
+    uint32_t head = NIL, tail = NIL;  // most / least recently used
+    size_t used = 0;
+
+    size_t home(u64 block) const { return (block * 0x9E3779B97F4A7C15ULL) >> slot_shift; }
+    size_t find_slot(u64 block) const;
+    void erase_slot(size_t slot);
+    void unlink(uint32_t n);
+    void push_front(uint32_t n);
+    bool shadow_access(u64 block);
+
+public:
+    u64 compulsory = 0, capacity_misses = 0, conflict = 0;
+
+    explicit MissClassifier(size_t capacity);
+    // Every demand access to the level, in order, with its real outcome.
+    void observe(u64 block, bool hit);
+};
@@ -0,0 +1,312 @@
+#include "MultiCore.h"
+#include <algorithm>
+#include <condition_variable>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <stdexcept>
+#include <thread>
+
+// Reusable rendezvous for a fixed number of threads.
+class Barrier {
+private:
+    std::mutex lock;
+    std::condition_variable cv;
+    int count;
+    int waiting = 0;
+    unsigned generation = 0;
+
+public:
+    explicit Barrier(int n) : count(n) {}
+    void wait() {
+        std::unique_lock<std::mutex> guard(lock);
+        unsigned gen = generation;
+        if (++waiting == count) {
+            waiting = 0;
+            generation++;
+            cv.notify_all();
+            return;
+        }
+        cv.wait(guard, [&] { return gen != generation; });
+    }
+};
+
+MultiCoreSystem::MultiCoreSystem(int num_cores, const std::vector<CacheLevelSpec>& private_levels,
+                                 const CacheLevelSpec& shared_level, ReplacementPolicy p, int host_threads)
+    : line(shared_level.block_size), threads(host_threads > 0 ? host_threads : 1) {
+    if (num_cores < 1 || num_cores > 64) throw std::invalid_argument("Cores must be between 1 and 64");
+    if (private_levels.empty()) throw std::invalid_argument("Cores need at least one private level");
+    if (line == 0 || (line & (line - 1)) != 0) throw std::invalid_argument("Shared block size must be power of 2");
+    for (const CacheLevelSpec& spec : private_levels)
+        if (spec.block_size == 0 || spec.block_size > line || line % spec.block_size != 0)
+            throw std::invalid_argument("Private block sizes must divide the shared block size");
+
+    shared = make_cache_level(static_cast<int>(private_levels.size() + 1), shared_level.size,
+                              shared_level.block_size, shared_level.associativity, p);
+    cores.resize(num_cores);
+    for (Core& core : cores)
+        for (size_t i = 0; i < private_levels.size(); i++)
+            core.levels.push_back(make_cache_level(static_cast<int>(i + 1), private_levels[i].size,
+                                                   private_levels[i].block_size, private_levels[i].associativity, p));
+}
+
+void MultiCoreSystem::enqueue(int core, u64 address, bool is_write) {
+    cores[core].trace.push_back({address, is_write});
+}
+
+size_t MultiCoreSystem::queued() const {
+    size_t n = 0;
+    for (const Core& core : cores) n += core.trace.size() - core.pos;
+    return n;
+}
+
+bool MultiCoreSystem::owns(int c, u64 blk) const {
+    auto it = directory.find(blk);
+    return it != directory.end() && it->second.exclusive && it->second.sharers == (1ULL << c);
+}
+
+// Whether any private level of core c still holds part of the block.
+bool MultiCoreSystem::holds(int c, u64 blk) const {
+    for (const auto& level : cores[c].levels) {
+        u64 bs = level->block_size();
+        for (u64 a = blk; a < blk + line; a += bs)
+            if (level->probe(a)) return true;
+    }
+    return false;
+}
+
+bool MultiCoreSystem::drop_copies(int c, u64 blk) {
+    bool dirty = false;
+    for (auto& level : cores[c].levels)
+        if (level->invalidate_frame(blk, line)) dirty = true;
+    return dirty;
+}
+
+bool MultiCoreSystem::clean_copies(int c, u64 blk) {
+    bool dirty = false;
+    for (auto& level : cores[c].levels)
+        if (level->clean_frame(blk, line)) dirty = true;
+    return dirty;
+}
+
+// Bound phase for one core: touches only that core's private levels and
+// reads the directory, so cores can run concurrently.
+void MultiCoreSystem::advance(int c) {
+    Core& core = cores[c];
+    size_t n = core.levels.size();
+    while (core.pos < core.trace.size()) {
+        const Access& a = core.trace[core.pos];
+        core.accesses++;
+        size_t hit_at = n;
+        for (size_t i = 0; i < n; i++)
+            if (core.levels[i]->access(a.address, a.is_write)) { hit_at = i; break; }
+
+        if (hit_at == n) { core.pending = MISS; return; }
+        if (a.is_write && !owns(c, block_of(a.address))) {
+            core.pending = UPGRADE;
+            core.hit_level = hit_at;
+            return;
+        }
+        if (hit_at > 0) fill_private(c, hit_at, a.address, a.is_write);
+        core.pos++;
+    }
+}
+
+// Serial phase for one blocked core.
+void MultiCoreSystem::resolve(int c) {
+    Core& core = cores[c];
+    const Access& a = core.trace[core.pos];
+    u64 blk = block_of(a.address);
+
+    // An earlier core in this phase may have invalidated the shared copy;
+    // the write then has to fetch the block like a miss.
+    if (core.pending == UPGRADE && holds(c, blk)) {
+        DirEntry& e = directory[blk];
+        invalidate_sharers(c, blk, e);
+        e.sharers = 1ULL << c;
+        e.exclusive = true;
+        core.upgrades++;
+        if (core.hit_level > 0) fill_private(c, core.hit_level, a.address, true);
+    } else {
+        miss(c, a.address, a.is_write);
+    }
+    flush_writebacks(c);
+    core.pending = NONE;
+    core.pos++;
+}
+
+void MultiCoreSystem::miss(int c, u64 address, bool is_write) {
+    Core& core = cores[c];
+    u64 blk = block_of(address);
+    uint64_t self = 1ULL << c;
+    bool from_peer = false;
+
+    // c may already be listed when it holds another private block of the
+    // same coherence block.
+    DirEntry& e = directory[blk];
+    uint64_t others = e.sharers & ~self;
+    if (others && e.exclusive) {
+        // The owner supplies the block (E or M) cache-to-cache.
+        int owner = __builtin_ctzll(others);
+        from_peer = true;
+        cores[owner].c2c_sent++;
+        core.c2c_received++;
+        if (is_write) {
+            drop_copies(owner, blk);   // dirty data moves with the block
+            cores[owner].invalidations++;
+        } else if (clean_copies(owner, blk)) {
+            shared->mark_dirty(blk);
+            cores[owner].writebacks++;
+        }
+        e.exclusive = is_write;
+    } else if (others && is_write) {
+        invalidate_sharers(c, blk, e);
+        e.exclusive = true;
+    } else if (!others) {
+        e.exclusive = true;
+    }
+    e.sharers = is_write ? self : (e.sharers | self);
+
+    if (!from_peer && !shared->access(address, false)) fill_shared(address);
+    fill_private(c, core.levels.size(), address, is_write);
+}
+
+// Invalidates every sharer of blk other than c.
+void MultiCoreSystem::invalidate_sharers(int c, u64 blk, const DirEntry& e) {
+    for (int s = 0; s < num_cores(); s++) {
+        if (s == c || !(e.sharers & (1ULL << s))) continue;
+        if (drop_copies(s, blk)) {
+            shared->mark_dirty(blk);
+            cores[s].writebacks++;
+        }
+        cores[s].invalidations++;
+    }
+}
+
+// Shared-level victims are back-invalidated from every core.
+void MultiCoreSystem::fill_shared(u64 address) {
+    u64 ev_addr; bool ev_dirty = false;
+    if (!shared->insert(address, false, ev_addr, ev_dirty)) return;
+    auto it = directory.find(block_of(ev_addr));
+    if (it != directory.end()) {
+        for (int s = 0; s < num_cores(); s++) {
+            if (!(it->second.sharers & (1ULL << s))) continue;
+            if (drop_copies(s, it->first)) ev_dirty = true;
+            cores[s].back_invalidations++;
+        }
+        directory.erase(it);
+    }
+    if (ev_dirty) memory_writebacks++;
+}
+
+// Fills private levels from-1 down to 0 of core c.
+void MultiCoreSystem::fill_private(int c, size_t from, u64 address, bool dirty) {
+    Core& core = cores[c];
+    for (size_t j = from; j-- > 0;) {
+        u64 ev_addr; bool ev_dirty = false;
+        if (core.levels[j]->insert(address, dirty, ev_addr, ev_dirty)) evict_private(c, j, ev_addr, ev_dirty);
+    }
+}
+
+void MultiCoreSystem::evict_private(int c, size_t idx, u64 victim, bool dirty) {
+    Core& core = cores[c];
+    u64 span = core.levels[idx]->block_size();
+    for (size_t up = 0; up < idx; up++)
+        if (core.levels[up]->invalidate_frame(victim, span)) dirty = true;
+    if (dirty && !(idx + 1 < core.levels.size() && core.levels[idx + 1]->mark_dirty(victim))) {
+        // The bound phase may get here on several host threads at once, so
+        // the shared level is only written from the serial phase.
+        core.shared_writebacks.push_back(victim);
+        core.writebacks++;
+    }
+
+    u64 blk = block_of(victim);
+    if (idx + 1 < core.levels.size() || holds(c, blk)) return;
+    auto it = directory.find(blk);
+    if (it == directory.end()) return;
+    it->second.sharers &= ~(1ULL << c);
+    if (!it->second.sharers) directory.erase(it);
+}
+
+void MultiCoreSystem::flush_writebacks(int c) {
+    for (u64 victim : cores[c].shared_writebacks) shared->mark_dirty(victim);
+    cores[c].shared_writebacks.clear();
+}
+
+void MultiCoreSystem::run_rounds(int tid, int nthreads, Barrier* barrier, bool* work) {
+    while (true) {
+        for (int c = tid; c < num_cores(); c += nthreads)
+            if (cores[c].pending == NONE) advance(c);
+        if (barrier) barrier->wait();
+        if (tid == 0) {
+            *work = false;
+            for (int c = 0; c < num_cores(); c++) flush_writebacks(c);
+            for (int c = 0; c < num_cores(); c++)
+                if (cores[c].pending != NONE) resolve(c);
+            for (const Core& core : cores)
+                if (core.pos < core.trace.size()) *work = true;
+        }
+        if (barrier) barrier->wait();
+        if (!*work) return;
+    }
+}
+
+size_t MultiCoreSystem::sync() {
+    size_t n = queued();
+    if (n == 0) return 0;
+    int nthreads = std::min(threads, num_cores());
+    bool work = true;
+    if (nthreads <= 1) {
+        run_rounds(0, 1, nullptr, &work);
+    } else {
+        Barrier barrier(nthreads);
+        std::vector<std::thread> workers;
+        for (int t = 1; t < nthreads; t++)
+            workers.emplace_back(&MultiCoreSystem::run_rounds, this, t, nthreads, &barrier, &work);
+        run_rounds(0, nthreads, &barrier, &work);
+        for (auto& w : workers) w.join();
+    }
+    for (Core& core : cores) {
+        core.trace.clear();
+        core.pos = 0;
+    }
+    epochs++;
+    return n;
+}
+
+void MultiCoreSystem::display_stats() const {
+    u64 accesses = 0, upgrades = 0, invalidations = 0, back_invalidations = 0, c2c = 0, writebacks = 0;
+    std::cout << "\n--- Multi-Core Statistics (" << cores.size() << " cores, " << threads
+              << " host threads, " << epochs << " epochs) ---\n" << std::setfill(' ');
+    for (size_t c = 0; c < cores.size(); c++) {
+        const Core& core = cores[c];
+        std::cout << "Core " << c << ": Accesses=" << core.accesses
+                  << " | Upgrades=" << core.upgrades
+                  << " | Invalidations=" << core.invalidations
+                  << " | Back-invalidations=" << core.back_invalidations
+                  << " | C2C sent=" << core.c2c_sent
+                  << " | C2C received=" << core.c2c_received
+                  << " | Writebacks=" << core.writebacks << "\n";
+        for (const auto& level : core.levels) {
+            std::cout << "  ";
+            level->display_stats();
+        }
+        accesses += core.accesses;
+        upgrades += core.upgrades;
+        invalidations += core.invalidations;
+        back_invalidations += core.back_invalidations;
+        c2c += core.c2c_received;
+        writebacks += core.writebacks;
+    }
+    std::cout << "All cores: Accesses=" << accesses
+              << " | Upgrades=" << upgrades
+              << " | Invalidations=" << invalidations
+              << " | Back-invalidations=" << back_invalidations
+              << " | C2C transfers=" << c2c
+              << " | Writebacks=" << writebacks
+              << " | Memory writebacks=" << memory_writebacks << "\n";
+    std::cout << "Shared ";
+    shared->display_stats();
+    std::cout << "Directory entries: " << directory.size() << "\n";
+    std::cout << "----------------------------------\n";
+}
@@ -0,0 +1,84 @@
+#pragma once
+#include <cstdint>
+#include <memory>
+#include <unordered_map>
+#include <vector>
+#include "Cache.h"
+
+class Barrier;
+
+// N cores, each with a private inclusive stack of cache levels, in front of
+// one shared inclusive last level. Coherence is MESI through a directory kept
+// beside the shared level: an entry lists the cores holding a block and
+// whether one of them owns it exclusively (E, or M once its copy is dirty).
+// Blocks are tracked at the shared level's block size; private blocks must
+// divide it.
+//
+// Accesses are queued per core and run at synchronization points in rounds:
+// every core first advances through its queue on its own host thread for as
+// long as its private caches can answer alone (read hits, write hits on an
+// owned block), then the blocked misses and upgrades are resolved serially in
+// core order against the directory and shared level. The result depends only
+// on the queued traces, never on the number of host threads.
+class MultiCoreSystem {
+private:
+    struct Access {
+        u64 address;
+        bool is_write;
+    };
+
+    enum PendingKind { NONE, UPGRADE, MISS };
+
+    struct Core {
+        std::vector<std::unique_ptr<CacheModel>> levels;
+        std::vector<Access> trace;   // the current epoch
+        size_t pos = 0;
+        PendingKind pending = NONE;
+        size_t hit_level = 0;        // private level an UPGRADE hit in
+        std::vector<u64> shared_writebacks;   // dirty victims for the shared level, applied serially
+        u64 accesses = 0, upgrades = 0, invalidations = 0, back_invalidations = 0;
+        u64 c2c_sent = 0, c2c_received = 0, writebacks = 0;
+    };
+
+    struct DirEntry {
+        uint64_t sharers = 0;        // bit per core
+        bool exclusive = false;
+    };
+
+    std::vector<Core> cores;
+    std::unique_ptr<CacheModel> shared;
+    std::unordered_map<u64, DirEntry> directory;
+    u64 line;
+    int threads;
+    u64 memory_writebacks = 0;
+    u64 epochs = 0;
+
+    u64 block_of(u64 address) const { return address & ~(line - 1); }
+    bool owns(int c, u64 blk) const;
+    bool holds(int c, u64 blk) const;
+    bool drop_copies(int c, u64 blk);
+    bool clean_copies(int c, u64 blk);
+    void advance(int c);
+    void resolve(int c);
+    void miss(int c, u64 address, bool is_write);
+    void invalidate_sharers(int c, u64 blk, const DirEntry& e);
+    void fill_private(int c, size_t from, u64 address, bool dirty);
+    void evict_private(int c, size_t idx, u64 victim, bool dirty);
+    void flush_writebacks(int c);
+    void fill_shared(u64 address);
+    void run_rounds(int tid, int nthreads, Barrier* barrier, bool* work);
+
+public:
+    // Throws std::invalid_argument for 0 or more than 64 cores, no private
+    // levels, or private blocks that do not divide the shared block.
+    MultiCoreSystem(int num_cores, const std::vector<CacheLevelSpec>& private_levels,
+                    const CacheLevelSpec& shared_level, ReplacementPolicy p = LRU, int host_threads = 1);
+
+    int num_cores() const { return static_cast<int>(cores.size()); }
+    void set_threads(int n) { threads = n > 0 ? n : 1; }
+    void enqueue(int core, u64 address, bool is_write);
+    size_t queued() const;
+    // Runs every queued access; returns how many ran.
+    size_t sync();
+    void display_stats() const;
+};
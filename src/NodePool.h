@@ -0,0 +1,65 @@
+#pragma once
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+// Fixed-type node arena for allocator metadata (Mem_Block, BuddyBlock, ...).
+// Nodes are carved from contiguous chunks, freed nodes go on an intrusive free
+// list for reuse, and reset() recycles every chunk in O(1) without touching the
+// nodes, which is why T must be trivially destructible.
+template <typename T, size_t ChunkSize = 512>
+class NodePool {
+    static_assert(std::is_trivially_destructible<T>::value, "NodePool nodes are never destroyed individually");
+
+private:
+    union Slot {
+        Slot* next_free;
+        alignas(T) unsigned char storage[sizeof(T)];
+    };
+
+    std::vector<std::unique_ptr<Slot[]>> chunks;
+    size_t chunk_idx = 0;   // chunk the bump pointer is in
+    size_t slot_idx = 0;    // next never-used slot in that chunk
+    Slot* free_list = nullptr;
+
+    Slot* take_slot() {
+        if (free_list) {
+            Slot* s = free_list;
+            free_list = s->next_free;
+            return s;
+        }
+        if (slot_idx == ChunkSize) {
+            chunk_idx++;
+            slot_idx = 0;
+        }
+        if (chunk_idx == chunks.size()) chunks.emplace_back(new Slot[ChunkSize]);
+        return &chunks[chunk_idx][slot_idx++];
+    }
+
+public:
+    NodePool() = default;
+    NodePool(const NodePool&) = delete;
+    NodePool& operator=(const NodePool&) = delete;
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        Slot* s = take_slot();
+        return new (s->storage) T(std::forward<Args>(args)...);
+    }
+
+    void destroy(T* node) {
+        Slot* s = reinterpret_cast<Slot*>(node);
+        s->next_free = free_list;
+        free_list = s;
+    }
+
+    // Invalidates every node handed out so far; chunks are kept for reuse.
+    void reset() {
+        chunk_idx = 0;
+        slot_idx = 0;
+        free_list = nullptr;
+    }
+};
@@ -0,0 +1,110 @@
+#include "PageTable.h"
+#include <stdexcept>
+
+PageTable::PageTable(unsigned vpn_bits) {
+    if (vpn_bits < 64 && (1ULL << vpn_bits) <= FLAT_LIMIT) {
+        flat.resize(1ULL << vpn_bits);
+        return;
+    }
+    // The levels below the root split the bits evenly; the root takes the rest.
+    level_bits = (vpn_bits + LEVELS - 1) / LEVELS;
+    root_fanout = 1ULL << (vpn_bits - (LEVELS - 1) * level_bits);
+    root = make_node(0);
+}
+
+std::unique_ptr<PageTable::Node> PageTable::make_node(int level) const {
+    auto node = std::make_unique<Node>();
+    u64 fanout = level == 0 ? root_fanout : 1ULL << level_bits;
+    if (level == LEVELS - 1) node->entries = std::make_unique<PageTableEntry[]>(fanout);
+    else node->children = std::make_unique<std::unique_ptr<Node>[]>(fanout);
+    return node;
+}
+
+PageTableEntry* PageTable::find(u64 vpn, int* level) {
+    int stop = 0;
+    if (!level) level = &stop;
+    *level = 0;
+    if (!root) return &flat[vpn];
+    Node* node = root.get();
+    for (int L = 0; L < LEVELS - 1; L++) {
+        u64 idx = index_of(vpn, L);
+        *level = L;
+        if (node->huge && node->huge[idx].valid) return &node->huge[idx];
+        node = node->children[idx].get();
+        if (!node) return nullptr;
+    }
+    *level = LEVELS - 1;
+    return &node->entries[index_of(vpn, LEVELS - 1)];
+}
+
+PageTableEntry& PageTable::map(u64 vpn) {
+    if (!root) return flat[vpn];
+    Node* node = root.get();
+    for (int level = 0; level < LEVELS - 1; level++) {
+        std::unique_ptr<Node>& child = node->children[index_of(vpn, level)];
+        if (!child) {
+            child = make_node(level + 1);
+            if (level + 1 == LEVELS - 1) leaf_nodes++; else interior_nodes++;
+        }
+        node = child.get();
+    }
+    return node->entries[index_of(vpn, LEVELS - 1)];
+}
+
+bool PageTable::has_mappings(const Node* node, int level) const {
+    u64 fanout = level == 0 ? root_fanout : 1ULL << level_bits;
+    for (u64 i = 0; i < fanout; i++) {
+        if (level == LEVELS - 1) {
+            if (node->entries[i].valid) return true;
+            continue;
+        }
+        if (node->huge && node->huge[i].valid) return true;
+        if (node->children[i] && has_mappings(node->children[i].get(), level + 1)) return true;
+    }
+    return false;
+}
+
+// Drops the node counts of a subtree about to be freed.
+void PageTable::release(const Node* node, int level) {
+    if (node->huge) huge_arrays--;
+    if (level == LEVELS - 1) { leaf_nodes--; return; }
+    interior_nodes--;
+    for (u64 i = 0; i < (1ULL << level_bits); i++)
+        if (node->children[i]) release(node->children[i].get(), level + 1);
+}
+
+void PageTable::map_huge(u64 vpn, int level, int frame) {
+    if (!root) throw std::invalid_argument("Huge pages need a multi-level page table");
+    if (level < 1 || level > LEVELS - 2) throw std::invalid_argument("Huge pages map at levels 1 to 2");
+    Node* node = root.get();
+    for (int L = 0; L < level; L++) {
+        u64 idx = index_of(vpn, L);
+        if (node->huge && node->huge[idx].valid) throw std::invalid_argument("Range is already mapped");
+        std::unique_ptr<Node>& child = node->children[idx];
+        if (!child) {
+            child = make_node(L + 1);
+            if (L + 1 == LEVELS - 1) leaf_nodes++; else interior_nodes++;
+        }
+        node = child.get();
+    }
+    u64 idx = index_of(vpn, level);
+    if (node->huge && node->huge[idx].valid) throw std::invalid_argument("Range is already mapped");
+    if (std::unique_ptr<Node>& child = node->children[idx]) {
+        if (has_mappings(child.get(), level + 1)) throw std::invalid_argument("Range is already mapped");
+        release(child.get(), level + 1);
+        child.reset();
+    }
+    if (!node->huge) {
+        node->huge = std::make_unique<PageTableEntry[]>(1ULL << level_bits);
+        huge_arrays++;
+    }
+    node->huge[idx] = {true, false, false, frame};
+}
+
+size_t PageTable::bytes() const {
+    if (!root) return flat.size() * sizeof(PageTableEntry);
+    size_t fanout = size_t(1) << level_bits;
+    return root_fanout * sizeof(std::unique_ptr<Node>)
+         + interior_nodes * fanout * sizeof(std::unique_ptr<Node>)
+         + (leaf_nodes + huge_arrays) * fanout * sizeof(PageTableEntry);
+}
@@ -0,0 +1,97 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <memory>
+#include <vector>
+
+typedef uint64_t u64;
+
+// Recency, load order and the CLOCK reference bit are kept per frame by
+// VirtualMemory, so an entry only holds the mapping itself. cow marks a
+// frame shared since a fork: the first write to it copies the page.
+struct PageTableEntry {
+    bool valid = false, dirty = false, cow = false;
+    int frame_number = -1;
+};
+
+// Maps virtual page numbers to PTEs. Spaces of up to FLAT_LIMIT pages use one
+// flat array; larger ones use a 4-level radix tree in the x86-64 layout (9
+// index bits per level for 48-bit addresses and 4KB pages), whose nodes are
+// only allocated when a page under them is first mapped. Memory then grows
+// with the pages touched rather than with the size of the space.
+//
+// Levels are numbered from the root (0) to the last level (LEVELS - 1). A
+// huge page is a leaf entry at an interior level below the root, covering
+// every base page that level's child would have mapped: 2MB at level 2 and
+// 1GB at level 1 in the x86-64 layout.
+class PageTable {
+private:
+    struct Node {
+        std::unique_ptr<std::unique_ptr<Node>[]> children;   // interior levels
+        std::unique_ptr<PageTableEntry[]> entries;           // last level
+        std::unique_ptr<PageTableEntry[]> huge;              // huge leaves, on first use
+    };
+
+    std::vector<PageTableEntry> flat;
+    std::unique_ptr<Node> root;
+    unsigned level_bits = 0;          // index bits below the root
+    u64 root_fanout = 0;
+    size_t interior_nodes = 0, leaf_nodes = 0, huge_arrays = 0;
+
+    std::unique_ptr<Node> make_node(int level) const;
+    unsigned shift_of(int level) const { return (LEVELS - 1 - level) * level_bits; }
+    u64 index_of(u64 vpn, int level) const { return (vpn >> shift_of(level)) & ((1ULL << level_bits) - 1); }
+    bool has_mappings(const Node* node, int level) const;
+    void release(const Node* node, int level);
+
+    template <class Fn>
+    void visit(Node* node, int level, u64 prefix, Fn& fn) {
+        u64 fanout = level == 0 ? root_fanout : 1ULL << level_bits;
+        for (u64 i = 0; i < fanout; i++) {
+            u64 vpn = (prefix << level_bits) | i;
+            if (level == LEVELS - 1) {
+                if (node->entries[i].valid) fn(vpn, level, node->entries[i]);
+                continue;
+            }
+            if (node->huge && node->huge[i].valid) fn(vpn << shift_of(level), level, node->huge[i]);
+            if (node->children[i]) visit(node->children[i].get(), level + 1, vpn, fn);
+        }
+    }
+
+public:
+    static constexpr int LEVELS = 4;
+    static constexpr u64 FLAT_LIMIT = 1ULL << 16;
+
+    // vpn_bits is log2 of the number of virtual pages.
+    explicit PageTable(unsigned vpn_bits);
+
+    bool is_flat() const { return !root; }
+    unsigned get_level_bits() const { return level_bits; }
+    // Base pages covered by a leaf at level.
+    unsigned page_shift_at(int level) const { return root ? shift_of(level) : 0; }
+    // The PTE for vpn, or nullptr when nothing under it was ever mapped.
+    // Never allocates. level, if given, receives the level of the last entry
+    // read: the leaf's, or the first missing one's (0 for a flat table).
+    PageTableEntry* find(u64 vpn, int* level = nullptr);
+    // The PTE for vpn, allocating the missing nodes on its path.
+    PageTableEntry& map(u64 vpn);
+    // Maps the aligned huge page containing vpn with a leaf at level (1 to
+    // LEVELS - 2) starting at frame. Throws std::invalid_argument for a flat
+    // table, a bad level, or a range that already has a valid mapping; a
+    // subtree left with no valid mappings is released.
+    void map_huge(u64 vpn, int level, int frame);
+
+    // Calls fn(vpn, level, entry) for every valid entry; for a huge leaf vpn
+    // is its first base page.
+    template <class Fn>
+    void for_each_mapping(Fn fn) {
+        if (root) { visit(root.get(), 0, 0, fn); return; }
+        for (u64 vpn = 0; vpn < flat.size(); vpn++)
+            if (flat[vpn].valid) fn(vpn, 0, flat[vpn]);
+    }
+
+    // Radix nodes including the root; 0 for a flat table.
+    size_t node_count() const { return root ? 1 + interior_nodes + leaf_nodes : 0; }
+    // Bytes held by PTEs (base and huge) and child pointers.
+    size_t bytes() const;
+};
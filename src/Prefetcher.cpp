@@ -0,0 +1,66 @@
+#include "Prefetcher.h"
+#include <cmath>
+
+void NextLinePrefetcher::observe(u64 block_addr, bool hit, std::vector<u64>& out) {
+    if (hit) return;
+    for (int i = 1; i <= degree; i++) out.push_back(block_addr + i * block_size);
+}
+
+StridePrefetcher::StridePrefetcher(u64 bs, int d, u64 region_blocks)
+    : Prefetcher(bs, d), region_bits(static_cast<u64>(std::log2(bs * region_blocks))), table(TABLE_SIZE) {}
+
+void StridePrefetcher::observe(u64 block_addr, bool, std::vector<u64>& out) {
+    u64 region = block_addr >> region_bits;
+    Entry& e = table[region % TABLE_SIZE];
+    if (e.region != region) {
+        e = Entry();
+        e.region = region;
+        e.last_addr = block_addr;
+        return;
+    }
+
+    int64_t stride = static_cast<int64_t>(block_addr - e.last_addr);
+    if (stride == 0) return;
+    if (stride == e.stride) {
+        if (e.confidence < 3) e.confidence++;
+    } else if (e.confidence > 0) {
+        e.confidence--;
+    } else {
+        e.stride = stride;
+    }
+    e.last_addr = block_addr;
+
+    if (e.confidence < CONFIDENT) return;
+    for (int i = 1; i <= degree; i++) {
+        int64_t next = static_cast<int64_t>(block_addr) + e.stride * i;
+        if (next < 0) break;
+        out.push_back(static_cast<u64>(next));
+    }
+}
+
+StreamPrefetcher::StreamPrefetcher(u64 bs, int d, size_t num_streams)
+    : Prefetcher(bs, d), streams(num_streams) {}
+
+void StreamPrefetcher::observe(u64 block_addr, bool hit, std::vector<u64>& out) {
+    clock++;
+    for (Stream& s : streams) {
+        if (!s.active || block_addr < s.head || block_addr >= s.issued_to) continue;
+        s.head = block_addr + block_size;
+        s.last_use = clock;
+        u64 target = s.head + degree * block_size;
+        for (; s.issued_to < target; s.issued_to += block_size) out.push_back(s.issued_to);
+        return;
+    }
+    if (hit) return;
+
+    Stream* victim = &streams[0];
+    for (Stream& s : streams) {
+        if (!s.active) { victim = &s; break; }
+        if (s.last_use < victim->last_use) victim = &s;
+    }
+    victim->active = true;
+    victim->head = block_addr + block_size;
+    victim->issued_to = victim->head;
+    victim->last_use = clock;
+    for (int i = 0; i < degree; i++, victim->issued_to += block_size) out.push_back(victim->issued_to);
+}
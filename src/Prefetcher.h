@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+typedef uint64_t u64;
+
+// Watches the demand stream reaching one cache level and proposes block
+// addresses to fill ahead of it. Addresses passed in and out are aligned to
+// the level's block size; MemoryHierarchy drops proposals already resident.
+class Prefetcher {
+protected:
+    u64 block_size;
+    int degree;
+
+public:
+    Prefetcher(u64 bs, int d) : block_size(bs), degree(d > 0 ? d : 1) {}
+    virtual ~Prefetcher() = default;
+    virtual const char* name() const = 0;
+    virtual void observe(u64 block_addr, bool hit, std::vector<u64>& out) = 0;
+    int get_degree() const { return degree; }
+};
+
+// Fetches the next `degree` blocks after every miss.
+class NextLinePrefetcher : public Prefetcher {
+public:
+    NextLinePrefetcher(u64 bs, int d) : Prefetcher(bs, d) {}
+    const char* name() const override { return "next_line"; }
+    void observe(u64 block_addr, bool hit, std::vector<u64>& out) override;
+};
+
+// Learns one stride per address region (no PC is available to key on) and
+// runs `degree` strides ahead once the same stride has repeated twice. A
+// region spans region_blocks blocks, so it scales with the level's block size.
+class StridePrefetcher : public Prefetcher {
+private:
+    struct Entry {
+        u64 region = ~0ULL;
+        u64 last_addr = 0;
+        int64_t stride = 0;
+        int confidence = 0;  // 2-bit saturating
+    };
+    static constexpr size_t TABLE_SIZE = 64;
+    static constexpr int CONFIDENT = 2;
+    u64 region_bits;
+    std::vector<Entry> table;
+
+public:
+    StridePrefetcher(u64 bs, int d, u64 region_blocks = 64);
+    const char* name() const override { return "stride"; }
+    void observe(u64 block_addr, bool hit, std::vector<u64>& out) override;
+};
+
+// A small set of ascending stream buffers. A miss outside every stream
+// claims the least recently used one and fills `degree` blocks past it; a
+// demand access inside a stream's window slides it forward, keeping the
+// stream `degree` blocks ahead of the consumer.
+class StreamPrefetcher : public Prefetcher {
+private:
+    struct Stream {
+        bool active = false;
+        u64 head = 0;       // next block the consumer is expected to touch
+        u64 issued_to = 0;  // one past the furthest block already requested
+        u64 last_use = 0;
+    };
+    std::vector<Stream> streams;
+    u64 clock = 0;
+
+public:
+    StreamPrefetcher(u64 bs, int d, size_t num_streams = 4);
+    const char* name() const override { return "stream"; }
+    void observe(u64 block_addr, bool hit, std::vector<u64>& out) override;
+};
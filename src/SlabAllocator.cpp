@@ -0,0 +1,257 @@
+#include "SlabAllocator.h"
+#include <iostream>
+#include <iomanip>
+#include <climits>
+
+static const size_t SLAB_CLASS_SIZES[] = {8, 16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 1024};
+
+SlabAllocator::~SlabAllocator() {
+    release_all();
+}
+
+void SlabAllocator::list_push(Slab*& head, Slab* s) {
+    s->prev = nullptr;
+    s->next = head;
+    if (head) head->prev = s;
+    head = s;
+}
+
+void SlabAllocator::list_remove(Slab*& head, Slab* s) {
+    if (s->prev) s->prev->next = s->next;
+    else head = s->next;
+    if (s->next) s->next->prev = s->prev;
+    s->prev = s->next = nullptr;
+}
+
+// Drops every slab; their pages go back when the page source is re-initialized.
+void SlabAllocator::release_all() {
+    for (auto& c : classes) {
+        for (Slab* head : {c.partial, c.full, c.empty}) {
+            while (head) {
+                Slab* temp = head;
+                head = head->next;
+                delete temp;
+            }
+        }
+    }
+    classes.clear();
+    class_of.clear();
+    objects.clear();
+    large_bytes = large_requested = large_count = 0;
+}
+
+void SlabAllocator::init(size_t mem_size) {
+    release_all();
+    total_size = mem_size;
+    total_alloc_attempts = successful_allocations = 0;
+    page_source.init(mem_size);
+    if (mem_size == 0) return;
+
+    // Largest power of two <= mem_size / 4, clamped to [MIN, MAX] slab size.
+    slab_size = MIN_SLAB_SIZE;
+    while (slab_size < MAX_SLAB_SIZE && slab_size * 2 <= mem_size / 4) slab_size *= 2;
+
+    for (size_t sz : SLAB_CLASS_SIZES) {
+        if (slab_size / sz < MIN_OBJS_PER_SLAB) break;
+        SizeClass c;
+        c.obj_size = sz;
+        c.objs_per_slab = static_cast<unsigned>(slab_size / sz);
+        classes.push_back(c);
+    }
+
+    size_t max_small = classes.empty() ? 0 : classes.back().obj_size;
+    class_of.assign(max_small / 8 + 1, 0);
+    int cls = 0;
+    for (size_t i = 1; i < class_of.size(); i++) {
+        while (classes[cls].obj_size < i * 8) cls++;
+        class_of[i] = static_cast<uint8_t>(cls);
+    }
+
+    if (announce) std::cout << "[System] Slab Allocator Initialized: " << classes.size()
+              << " size classes, " << slab_size << "-byte slabs.\n";
+}
+
+Slab* SlabAllocator::grow(int cls) {
+    int page = page_source.allocate(slab_size, Firstfit);
+    if (page == -1) return nullptr;
+    SizeClass& c = classes[cls];
+    Slab* s = new Slab(page, page_source.get_address(page), cls, c.objs_per_slab);
+    c.num_slabs++;
+    return s;
+}
+
+int SlabAllocator::allocate(size_t mem_size, Alloc_Algo algo) {
+    if (mem_size == 0) return -1;
+    total_alloc_attempts++;
+
+    // Compare before rounding: (mem_size + 7) would wrap for sizes near SIZE_MAX.
+    if (class_of.empty() || mem_size > (class_of.size() - 1) * 8) {
+        int page = page_source.allocate(mem_size, algo);
+        if (page == -1) return -1;
+        large_count++;
+        large_requested += mem_size;
+        large_bytes += page_source.get_block_size(page);
+        successful_allocations++;
+        return objects.insert({nullptr, page, mem_size});
+    }
+
+    int cls = class_of[(mem_size + 7) / 8];
+    SizeClass& c = classes[cls];
+    Slab* s = c.partial;
+    if (!s && c.empty) {
+        s = c.empty;
+        list_remove(c.empty, s);
+        c.num_empty--;
+        list_push(c.partial, s);
+    }
+    if (!s) {
+        s = grow(cls);
+        if (!s) return -1;
+        list_push(c.partial, s);
+    }
+
+    uint16_t slot = s->free_slots.back();
+    s->free_slots.pop_back();
+    s->in_use++;
+    if (s->in_use == s->capacity) {
+        list_remove(c.partial, s);
+        list_push(c.full, s);
+    }
+
+    c.live_objects++;
+    c.requested_bytes += mem_size;
+    successful_allocations++;
+    return objects.insert({s, slot, mem_size});
+}
+
+void SlabAllocator::deallocate(int id) {
+    SlabObject obj;
+    if (!objects.erase(id, &obj)) return;
+
+    if (!obj.slab) {
+        large_count--;
+        large_requested -= obj.req_size;
+        large_bytes -= page_source.get_block_size(obj.slot_or_page);
+        page_source.deallocate(obj.slot_or_page);
+        return;
+    }
+
+    Slab* s = obj.slab;
+    SizeClass& c = classes[s->class_idx];
+    c.live_objects--;
+    c.requested_bytes -= obj.req_size;
+
+    bool was_full = (s->in_use == s->capacity);
+    s->free_slots.push_back(static_cast<uint16_t>(obj.slot_or_page));
+    s->in_use--;
+
+    if (was_full) {
+        list_remove(c.full, s);
+        list_push(c.partial, s);
+    }
+    if (s->in_use == 0) {
+        list_remove(c.partial, s);
+        if (c.num_empty < MAX_EMPTY_SLABS) {
+            list_push(c.empty, s);
+            c.num_empty++;
+        } else {
+            page_source.deallocate(s->page_id);
+            c.num_slabs--;
+            delete s;
+        }
+    }
+}
+
+int SlabAllocator::reallocate(int id, size_t new_size, Alloc_Algo algo) {
+    SlabObject* obj = objects.find(id);
+    if (!obj || new_size == 0) return -1;
+
+    if (obj->slab && new_size <= classes[obj->slab->class_idx].obj_size) {
+        SizeClass& c = classes[obj->slab->class_idx];
+        c.requested_bytes += new_size;
+        c.requested_bytes -= obj->req_size;
+        obj->req_size = new_size;
+        return id;
+    }
+
+    int new_id = allocate(new_size, algo);
+    if (new_id != -1) deallocate(id);
+    return new_id;
+}
+
+size_t SlabAllocator::get_address(int id) {
+    SlabObject* obj = objects.find(id);
+    if (!obj) return SIZE_MAX;
+    if (!obj->slab) return page_source.get_address(obj->slot_or_page);
+    return obj->slab->base + static_cast<size_t>(obj->slot_or_page) * classes[obj->slab->class_idx].obj_size;
+}
+
+void SlabAllocator::display() {
+    for (const auto& c : classes) {
+        std::cout << "Class " << c.obj_size << ": ";
+        const char* names[] = {"partial", "full", "empty"};
+        Slab* lists[] = {c.partial, c.full, c.empty};
+        for (int l = 0; l < 3; l++) {
+            for (Slab* s = lists[l]; s; s = s->next) {
+                std::cout << "[Addr:" << s->base << ", " << s->in_use << "/" << s->capacity
+                          << " " << names[l] << "] -> ";
+            }
+        }
+        std::cout << "nullptr\n";
+    }
+    std::cout << "Large: " << large_count << " block(s), " << large_bytes << " bytes\n";
+}
+
+// Per-class counters are maintained on every allocate/free; summing them over
+// the fixed number of classes keeps this O(1) in the number of objects.
+// "Free" here means unused object slots inside slabs.
+AllocatorStats SlabAllocator::snapshot() {
+    AllocatorStats s;
+    s.total_size = total_size;
+    s.used = large_bytes;
+    s.internal_frag = large_bytes - large_requested;
+    for (const auto& c : classes) {
+        size_t occupied = c.live_objects * c.obj_size;
+        size_t free_slots = c.num_slabs * c.objs_per_slab - c.live_objects;
+        s.used += occupied;
+        s.internal_frag += (occupied - c.requested_bytes) + c.num_slabs * (slab_size - c.objs_per_slab * c.obj_size);
+        s.free += free_slots * c.obj_size;
+        s.free_blocks += free_slots;
+        s.free_histogram[size_bucket(c.obj_size)] += free_slots;
+        if (free_slots) s.largest_free = c.obj_size;
+    }
+    return s;
+}
+
+void SlabAllocator::get_statistics() {
+    size_t used = large_bytes, internal_frag = large_bytes - large_requested;
+    size_t slab_bytes = 0;
+
+    std::cout << "--- Slab Classes ---\n";
+    for (const auto& c : classes) {
+        size_t capacity = c.num_slabs * c.objs_per_slab;
+        size_t occupied = c.live_objects * c.obj_size;
+        // Rounding waste of live objects plus the unusable tail of every slab.
+        size_t frag = (occupied - c.requested_bytes) + c.num_slabs * (slab_size - c.objs_per_slab * c.obj_size);
+        double occupancy = capacity > 0 ? (double)c.live_objects / capacity * 100.0 : 0.0;
+
+        std::cout << "Class " << std::setfill(' ') << std::setw(4) << c.obj_size << " B : slabs=" << c.num_slabs
+                  << " objects=" << c.live_objects << "/" << capacity
+                  << " occupancy=" << std::fixed << std::setprecision(0) << occupancy << "%"
+                  << " internal frag=" << frag << "\n";
+        slab_bytes += c.num_slabs * slab_size;
+        used += occupied;
+        internal_frag += frag;
+    }
+
+    double utilization = total_size > 0 ? (double)used / total_size * 100.0 : 0;
+    double success_rate = total_alloc_attempts > 0 ? (double)successful_allocations / total_alloc_attempts * 100.0 : 0;
+
+    std::cout << "Total memory: " << total_size << "\n";
+    std::cout << "Slab memory: " << slab_bytes << "\n";
+    std::cout << "Used memory: " << used << "\n";
+    std::cout << "Internal fragmentation: " << internal_frag << "\n";
+    std::cout << "Allocation success rate: " << std::fixed << std::setprecision(0) << success_rate << "%\n";
+    std::cout << "Memory utilization: " << utilization << "%\n";
+    print_free_histogram(snapshot());
+}
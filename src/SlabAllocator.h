@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+#include "Allocator.h"
+#include "BuddyAllocator.h"
+#include "HandleTable.h"
+
+// A slab holds `capacity` equally sized objects carved from one page-source block.
+struct Slab {
+    int page_id;            // block id in the page source
+    size_t base;            // address of the slab in the page source
+    int class_idx;
+    unsigned capacity;
+    unsigned in_use;
+    std::vector<uint16_t> free_slots;   // stack of free object indices
+    Slab* prev;
+    Slab* next;
+
+    Slab(int page, size_t addr, int cls, unsigned cap)
+        : page_id(page), base(addr), class_idx(cls), capacity(cap), in_use(0), prev(nullptr), next(nullptr) {
+        free_slots.reserve(cap);
+        for (unsigned i = cap; i > 0; i--) free_slots.push_back(static_cast<uint16_t>(i - 1));
+    }
+};
+
+// Object-cache allocator for small fixed-size objects. Each size class keeps
+// partial/full/empty slab lists, so allocate and deallocate are O(1). Slabs
+// are requested from a private buddy allocator over the slab's own arena,
+// and sizes above the largest class go straight to that page source.
+class SlabAllocator : public Allocator {
+private:
+    struct SizeClass {
+        size_t obj_size;
+        unsigned objs_per_slab;
+        Slab* partial = nullptr;
+        Slab* full = nullptr;
+        Slab* empty = nullptr;
+        size_t num_slabs = 0, num_empty = 0;
+        size_t live_objects = 0;
+        size_t requested_bytes = 0;
+    };
+
+    struct SlabObject {
+        Slab* slab;         // nullptr for large allocations
+        int slot_or_page;   // slot in the slab, or page-source id when large
+        size_t req_size;
+    };
+
+    static constexpr size_t MAX_SLAB_SIZE = 4096;
+    static constexpr size_t MIN_SLAB_SIZE = 64;
+    static constexpr unsigned MIN_OBJS_PER_SLAB = 4;
+    static constexpr size_t MAX_EMPTY_SLABS = 1;   // per class, beyond this pages go back
+
+    BuddyAllocator page_source{false};
+    size_t total_size = 0;
+    size_t slab_size = 0;
+    std::vector<SizeClass> classes;
+    std::vector<uint8_t> class_of;       // (size + 7) / 8 -> class index
+    HandleTable<SlabObject> objects;
+    size_t large_bytes = 0, large_requested = 0, large_count = 0;   // large_bytes counts whole buddy blocks
+    size_t total_alloc_attempts = 0;
+    size_t successful_allocations = 0;
+
+    static void list_push(Slab*& head, Slab* s);
+    static void list_remove(Slab*& head, Slab* s);
+    Slab* grow(int cls);
+    void release_all();
+
+public:
+    ~SlabAllocator();
+    void init(size_t mem_size) override;
+    std::unique_ptr<Allocator> make_empty() const override { return std::make_unique<SlabAllocator>(); }
+    int next_block_id() override { return objects.next_id(); }
+    int allocate(size_t mem_size, Alloc_Algo algo = Firstfit) override;
+    void deallocate(int id) override;
+    size_t get_address(int id) override;
+    void display() override;
+    void get_statistics() override;
+    AllocatorStats snapshot() override;
+    int reallocate(int id, size_t new_size, Alloc_Algo algo = Firstfit) override; // in place while it fits the object's class
+};
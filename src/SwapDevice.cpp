@@ -0,0 +1,172 @@
+#include "SwapDevice.h"
+#include <algorithm>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+#include <system_error>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static const u64 MAX_SLOTS = 1ULL << 24;
+
+SwapDevice::SwapDevice(const SwapSpec& s, u64 page) : spec(s) {
+    if (spec.size == 0 || spec.size > (1ULL << 40)) throw std::invalid_argument("Swap size must be 1 byte to 2^40");
+    if (spec.bandwidth == 0 || spec.readahead == 0 || spec.queue_depth == 0)
+        throw std::invalid_argument("Swap bandwidth, readahead and queue depth must be positive");
+
+    if (spec.path.empty()) {
+        char name[] = "/tmp/memsim-swap-XXXXXX";
+        fd = mkstemp(name);
+        if (fd != -1) unlink(name);
+    } else {
+        fd = open(spec.path.c_str(), O_RDWR | O_CREAT, 0644);
+    }
+    if (fd == -1) throw std::system_error(errno, std::generic_category(), "Cannot open the swap file");
+    void* mapped = MAP_FAILED;
+    if (ftruncate(fd, static_cast<off_t>(spec.size)) == 0)
+        mapped = mmap(nullptr, spec.size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (mapped == MAP_FAILED) {
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), "Cannot map the swap file");
+    }
+    data = static_cast<unsigned char*>(mapped);
+    reset(page);
+}
+
+SwapDevice::~SwapDevice() {
+    munmap(data, spec.size);
+    close(fd);
+}
+
+void SwapDevice::reset(u64 page) {
+    page_size = page;
+    slots.assign(std::min(spec.size / page, MAX_SLOTS), Slot());
+    free_slots.clear();
+    next_slot = 0;
+    page_buf.assign((page + 7) / 8, 0);
+    now = device_free = 0;
+    queue.clear();
+    swap_cache.clear();
+    reads = writes = bytes_read = bytes_written = 0;
+    readahead_pages = cache_hits = dropped = 0;
+    enqueued = depth_sum = peak_depth = stalls = stall_ns = 0;
+    faults = fault_ns = 0;
+}
+
+// Starts every queued write the device could have taken by now.
+void SwapDevice::drain() {
+    while (!queue.empty()) {
+        u64 start = std::max(device_free, queue.front().queued_at);
+        if (start > now) break;
+        device_free = start + io_time(page_size);
+        slots[queue.front().slot].queued = false;
+        queue.pop_front();
+        writes++;
+        bytes_written += page_size;
+    }
+}
+
+void SwapDevice::cache(u64 slot) {
+    slots[slot].cached = true;
+    swap_cache.push_back(slot);
+    if (swap_cache.size() > 4 * (size_t)spec.readahead) {
+        slots[swap_cache.front()].cached = false;
+        swap_cache.pop_front();
+    }
+}
+
+u64 SwapDevice::allocate() {
+    u64 slot;
+    if (!free_slots.empty()) {
+        slot = free_slots.back();
+        free_slots.pop_back();
+    } else if (next_slot < slots.size()) {
+        slot = next_slot++;
+    } else {
+        dropped++;
+        return NO_SLOT;
+    }
+    slots[slot].refs = 1;
+    slots[slot].cached = false;
+    return slot;
+}
+
+void SwapDevice::release(u64 slot) {
+    Slot& s = slots[slot];
+    if (--s.refs > 0) return;
+    s.cached = false;
+    free_slots.push_back(slot);
+}
+
+void SwapDevice::write(u64 slot, u64 key) {
+    drain();
+    std::fill(page_buf.begin(), page_buf.end(), key);
+    std::memcpy(data + slot * page_size, page_buf.data(), page_size);
+    Slot& s = slots[slot];
+    s.cached = false;
+    if (s.queued) return;   // the queued write will carry the new contents
+
+    if (queue.size() >= spec.queue_depth) {
+        // The device is busy, so the queue only moves when its write ends.
+        stalls++;
+        stall_ns += device_free - now;
+        now = device_free;
+        drain();
+    }
+    queue.push_back({slot, now});
+    s.queued = true;
+    enqueued++;
+    depth_sum += queue.size();
+    peak_depth = std::max<u64>(peak_depth, queue.size());
+    drain();
+}
+
+void SwapDevice::read(u64 slot) {
+    drain();
+    Slot& s = slots[slot];
+    if (s.queued || s.cached) {
+        cache_hits++;
+        s.cached = false;
+        return;
+    }
+    u64 pages = 1;
+    std::memcpy(page_buf.data(), data + slot * page_size, page_size);
+    u64 end = std::min<u64>(slot + spec.readahead, next_slot);
+    for (u64 next = slot + 1; next < end; next++) {
+        const Slot& ahead = slots[next];
+        if (!ahead.refs || ahead.queued || ahead.cached) continue;
+        std::memcpy(page_buf.data(), data + next * page_size, page_size);
+        cache(next);
+        pages++;
+    }
+    device_free = std::max(now, device_free) + io_time(pages * page_size);
+    now = device_free;
+    reads++;
+    bytes_read += pages * page_size;
+    readahead_pages += pages - 1;
+}
+
+void SwapDevice::get_statistics() const {
+    u64 in_use = next_slot - free_slots.size();
+    std::cout << std::setfill(' ') << std::fixed << std::setprecision(2);
+    std::cout << "Swap: " << slots.size() << " slots of " << page_size << "B, " << in_use << " in use | Latency="
+              << spec.latency_ns / 1000.0 << "us | Bandwidth=" << spec.bandwidth / 1048576.0
+              << "MB/s | Readahead=" << spec.readahead << " pages\n";
+    std::cout << "Swap I/O: Reads=" << reads << " (" << bytes_read << " bytes, " << readahead_pages
+              << " pages read ahead) | Writes=" << writes << " (" << bytes_written << " bytes) | Swap cache hits="
+              << cache_hits << "\n";
+    double avg_depth = enqueued ? (double)depth_sum / enqueued : 0.0;
+    std::cout << "Writeback queue: " << queue.size() << " pending | Avg depth=" << avg_depth << " | Peak="
+              << peak_depth << "/" << spec.queue_depth << " | Full stalls=" << stalls << " ("
+              << stall_ns / 1000.0 << "us)\n";
+    double avg_fault = faults ? fault_ns / 1000.0 / faults : 0.0;
+    std::cout << "Swap faults=" << faults << " | Avg fault latency=" << avg_fault << "us | Simulated time="
+              << now / 1e6 << "ms";
+    if (dropped) std::cout << " | Dropped writes (swap full)=" << dropped;
+    std::cout << "\n";
+}
@@ -0,0 +1,95 @@
+#pragma once
+#include <cstdint>
+#include <cstddef>
+#include <deque>
+#include <string>
+#include <vector>
+
+typedef uint64_t u64;
+
+struct SwapSpec {
+    u64 size = 1ULL << 24;            // bytes of swap space
+    u64 latency_ns = 100000;          // per I/O
+    u64 bandwidth = 500ULL << 20;     // bytes per second
+    unsigned readahead = 8;           // pages per read, the faulting one included
+    unsigned queue_depth = 32;        // writes waiting for the device
+    u64 gap_ns = 100;                 // simulated time between accesses
+    std::string path;                 // empty for an unlinked temporary file
+};
+
+// A swap area in a memory-mapped file, with a timing model for the device
+// behind it. Time is simulated in nanoseconds. The owner advances the clock
+// one gap per access, and a read stalls the clock until the device has
+// served it. Writes go on a queue that the device drains whenever it is
+// idle, so they stall only when the queue is full. The device serves one
+// I/O at a time in latency + bytes / bandwidth; a read waits for the write
+// in progress but overtakes the queued ones.
+//
+// Slots are reference counted, so the pages a fork shares keep one copy. A
+// read also fetches the allocated slots after the faulting one in the same
+// I/O and keeps them in a small swap cache. A later fault on a cached slot,
+// or on one whose write is still queued, is then served without I/O.
+class SwapDevice {
+private:
+    struct Slot {
+        uint32_t refs = 0;
+        bool queued = false, cached = false;
+    };
+
+    SwapSpec spec;
+    int fd = -1;
+    unsigned char* data = nullptr;    // the mapped file
+    u64 page_size = 0;
+    std::vector<Slot> slots;
+    std::vector<u64> free_slots;      // released slots, reused before new ones
+    u64 next_slot = 0;
+    std::vector<u64> page_buf;
+
+    u64 now = 0, device_free = 0;     // the device is busy until device_free
+    struct PendingWrite { u64 slot, queued_at; };
+    std::deque<PendingWrite> queue;
+    std::deque<u64> swap_cache;       // read-ahead slots, oldest first
+
+    u64 reads = 0, writes = 0, bytes_read = 0, bytes_written = 0;
+    u64 readahead_pages = 0, cache_hits = 0, dropped = 0;
+    u64 enqueued = 0, depth_sum = 0, peak_depth = 0, stalls = 0, stall_ns = 0;
+    u64 faults = 0, fault_ns = 0;
+
+    u64 io_time(u64 bytes) const {
+        return spec.latency_ns + static_cast<u64>((unsigned __int128)bytes * 1000000000ULL / spec.bandwidth);
+    }
+    void drain();
+    void cache(u64 slot);
+
+public:
+    static constexpr u64 NO_SLOT = ~0ULL;
+
+    // Throws std::invalid_argument for a zero bandwidth, readahead or queue
+    // depth or a size past 2^40, and std::system_error when the file cannot
+    // be created or mapped.
+    SwapDevice(const SwapSpec& s, u64 page);
+    ~SwapDevice();
+    SwapDevice(const SwapDevice&) = delete;
+    SwapDevice& operator=(const SwapDevice&) = delete;
+
+    // Divides the space into slots of page bytes (at most 2^24 of them),
+    // dropping every slot and statistic and restarting the clock.
+    void reset(u64 page);
+    u64 get_time() const { return now; }
+    void tick() { now += spec.gap_ns; drain(); }
+
+    // A slot with one reference, or NO_SLOT (counted as a dropped write)
+    // when the space is full.
+    u64 allocate();
+    void retain(u64 slot) { slots[slot].refs++; }
+    void release(u64 slot);
+    uint32_t refs(u64 slot) const { return slots[slot].refs; }
+
+    // Stores the page tagged key in slot and queues its write.
+    void write(u64 slot, u64 key);
+    // Reads slot back for a fault, with the read-ahead behind it.
+    void read(u64 slot);
+    // Accounts one page fault that took fault_time simulated nanoseconds.
+    void record_fault(u64 fault_time) { faults++; fault_ns += fault_time; }
+    void get_statistics() const;
+};
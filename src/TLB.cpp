@@ -0,0 +1,175 @@
+#include "TLB.h"
+#include "PageTable.h"
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <stdexcept>
+
+// Upper-level entries cached per page-table level, outermost first.
+static const int WALK_CACHE_ENTRIES[PageTable::LEVELS - 1] = {2, 4, 32};
+
+TLBLevel::TLBLevel(int num_entries, int assoc) : sets(0), ways(assoc) {
+    if (num_entries == 0) return;
+    if (num_entries < 0 || assoc <= 0 || num_entries % assoc != 0)
+        throw std::invalid_argument("TLB entries must be a positive multiple of the associativity");
+    sets = num_entries / assoc;
+    entries.resize(num_entries);
+}
+
+TLBEntry* TLBLevel::probe(uint16_t asid, u64 vpn, unsigned shift) {
+    u64 tag = vpn >> shift;
+    TLBEntry* set = &entries[(tag % sets) * ways];
+    for (int i = 0; i < ways; i++) {
+        const TLBEntry& e = set[i];
+        if (e.valid && e.tag == tag && e.asid == asid && e.size_shift == shift) {
+            std::rotate(set, set + i, set + i + 1);
+            return set;
+        }
+    }
+    return nullptr;
+}
+
+TLBEntry* TLBLevel::lookup(uint16_t asid, u64 vpn) {
+    if (!enabled()) return nullptr;
+    for (u64 held = shifts_held; held; held &= held - 1) {
+        TLBEntry* e = probe(asid, vpn, __builtin_ctzll(held));
+        if (e) { hits++; return e; }
+    }
+    misses++;
+    return nullptr;
+}
+
+TLBEntry* TLBLevel::insert(const TLBEntry& e) {
+    if (!enabled()) return nullptr;
+    TLBEntry* set = &entries[(e.tag % sets) * ways];
+    int victim = ways - 1;
+    for (int i = 0; i < ways; i++) {
+        const TLBEntry& cur = set[i];
+        if (cur.valid && cur.tag == e.tag && cur.asid == e.asid && cur.size_shift == e.size_shift) { victim = i; break; }
+        if (!cur.valid && victim == ways - 1) victim = i;
+    }
+    std::rotate(set, set + victim, set + victim + 1);
+    set[0] = e;
+    shifts_held |= 1ULL << e.size_shift;
+    return set;
+}
+
+void TLBLevel::invalidate(uint16_t asid, u64 vpn) {
+    if (!enabled()) return;
+    for (u64 held = shifts_held; held; held &= held - 1) {
+        unsigned shift = __builtin_ctzll(held);
+        u64 tag = vpn >> shift;
+        TLBEntry* set = &entries[(tag % sets) * ways];
+        for (int i = 0; i < ways; i++)
+            if (set[i].valid && set[i].tag == tag && set[i].asid == asid && set[i].size_shift == shift)
+                set[i].valid = false;
+    }
+}
+
+void TLBLevel::flush(uint16_t asid) {
+    for (TLBEntry& e : entries)
+        if (e.asid == asid) e.valid = false;
+}
+
+void TLBLevel::flush() {
+    for (TLBEntry& e : entries) e.valid = false;
+    shifts_held = 0;
+}
+
+TLB::TLB(int l1_entries, int l1_assoc, int l2_entries, int l2_assoc)
+    : l1(l1_entries, l1_assoc), l2(l2_entries, l2_assoc) {
+    if (!l1.enabled()) throw std::invalid_argument("The L1 TLB needs at least one entry");
+    for (int n : WALK_CACHE_ENTRIES) pwc.emplace_back(n, n);
+}
+
+void TLB::configure(int level, int entries, int assoc) {
+    TLBLevel fresh(entries, assoc);
+    if (level == 1 && !fresh.enabled()) throw std::invalid_argument("The L1 TLB needs at least one entry");
+    (level == 1 ? l1 : l2) = fresh;
+    reset();
+}
+
+TLBEntry* TLB::lookup(uint16_t asid, u64 vpn, int& hit_level) {
+    TLBEntry* e = l1.lookup(asid, vpn);
+    if (e) { hit_level = 1; return e; }
+    e = l2.lookup(asid, vpn);
+    if (!e) return nullptr;
+    hit_level = 2;
+    return l1.insert(*e);
+}
+
+void TLB::insert(uint16_t asid, u64 vpn, u64 pfn, unsigned size_shift, bool dirty) {
+    TLBEntry e;
+    e.valid = true;
+    e.dirty = dirty;
+    e.asid = asid;
+    e.size_shift = static_cast<uint8_t>(size_shift);
+    e.tag = vpn >> size_shift;
+    e.pfn = pfn;
+    l1.insert(e);
+    l2.insert(e);
+}
+
+void TLB::invalidate(uint16_t asid, u64 vpn) {
+    l1.invalidate(asid, vpn);
+    l2.invalidate(asid, vpn);
+}
+
+void TLB::flush() {
+    l1.flush();
+    l2.flush();
+    flush_walk_cache();
+}
+
+void TLB::flush(uint16_t asid) {
+    l1.flush(asid);
+    l2.flush(asid);
+    for (TLBLevel& level : pwc) level.flush(asid);
+}
+
+void TLB::flush_walk_cache() {
+    for (TLBLevel& level : pwc) level.flush();
+}
+
+void TLB::reset() {
+    flush();
+    l1.hits = l1.misses = l2.hits = l2.misses = 0;
+    for (TLBLevel& level : pwc) level.hits = level.misses = 0;
+    walks = walk_refs = 0;
+}
+
+int TLB::walk(uint16_t asid, u64 vpn, int stop_level, unsigned level_bits) {
+    // The entry for level L is named by the index bits of levels 0..L.
+    auto prefix = [&](int L) { return vpn >> ((PageTable::LEVELS - 1 - L) * level_bits); };
+    int start = 0;
+    for (int L = stop_level - 1; L >= 0; L--)
+        if (pwc[L].lookup(asid, prefix(L))) { start = L + 1; break; }
+    for (int L = start; L < stop_level; L++) {
+        TLBEntry e;
+        e.valid = true;
+        e.asid = asid;
+        e.tag = prefix(L);
+        pwc[L].insert(e);
+    }
+    int refs = stop_level - start + 1;
+    walks++;
+    walk_refs += refs;
+    return refs;
+}
+
+static void print_level(const char* name, const TLBLevel& level) {
+    u64 lookups = level.hits + level.misses;
+    double hr = lookups ? (double)level.hits / lookups * 100.0 : 0.0;
+    std::cout << name << " (" << level.size() << " entries, " << level.associativity() << "-way): "
+              << "Hits=" << level.hits << " | Misses=" << level.misses
+              << " | Hit Rate=" << std::fixed << std::setprecision(2) << hr << "%\n";
+}
+
+void TLB::get_statistics() const {
+    std::cout << std::setfill(' ');
+    print_level("TLB L1", l1);
+    if (l2.enabled()) print_level("TLB L2", l2);
+    std::cout << "Page walks=" << walks << " | Walk memory refs=" << walk_refs << " | Walk cache hits=";
+    for (size_t L = 0; L < pwc.size(); L++) std::cout << (L ? "/" : "") << pwc[L].hits;
+    std::cout << " (levels 1-" << pwc.size() << ")\n";
+}
@@ -0,0 +1,81 @@
+#pragma once
+#include <cstdint>
+#include <vector>
+
+typedef uint64_t u64;
+
+// A cached translation. Huge entries cover 2^size_shift base pages: tag is
+// the vpn shifted down by size_shift and pfn is the first base frame.
+struct TLBEntry {
+    bool valid = false, dirty = false;
+    uint16_t asid = 0;
+    uint8_t size_shift = 0;
+    u64 tag = 0, pfn = 0;
+};
+
+// One set-associative level of ASID-tagged entries. A level may hold several
+// page sizes at once; a lookup probes the set for each size it has held.
+// Every set is kept in recency order, most recent way first, so a hit
+// rotates its entry to the front and the victim is the last way.
+class TLBLevel {
+private:
+    int sets, ways;
+    std::vector<TLBEntry> entries;
+    u64 shifts_held = 0;        // bit per size_shift ever inserted
+
+    TLBEntry* probe(uint16_t asid, u64 vpn, unsigned shift);
+
+public:
+    u64 hits = 0, misses = 0;
+
+    // 0 entries makes a disabled level that always misses without counting.
+    // Throws std::invalid_argument unless entries is a multiple of assoc.
+    TLBLevel(int num_entries, int assoc);
+    bool enabled() const { return sets > 0; }
+    int size() const { return sets * ways; }
+    int associativity() const { return ways; }
+    TLBEntry* lookup(uint16_t asid, u64 vpn);
+    // Returns the entry's slot, or nullptr when the level is disabled.
+    TLBEntry* insert(const TLBEntry& e);
+    // Drops every entry of asid covering vpn.
+    void invalidate(uint16_t asid, u64 vpn);
+    void flush(uint16_t asid);
+    void flush();
+};
+
+// The MMU's translation caches: a small L1 dTLB in front of a larger unified
+// STLB, and a page-walk cache holding the upper-level (non-leaf) entries of
+// recent walks. A walk that finds the entry for level L cached starts reading
+// at level L + 1, so with a warm PDE cache a base-page walk costs one
+// memory reference instead of four.
+class TLB {
+private:
+    TLBLevel l1, l2;
+    std::vector<TLBLevel> pwc;  // one fully associative cache per non-leaf level
+    u64 walks = 0, walk_refs = 0;
+
+public:
+    TLB(int l1_entries = 16, int l1_assoc = 4, int l2_entries = 64, int l2_assoc = 4);
+    // Rebuilds level 1 or 2 and resets as reset() does; throws
+    // std::invalid_argument as TLBLevel.
+    void configure(int level, int entries, int assoc);
+    const TLBLevel& level(int n) const { return n == 1 ? l1 : l2; }
+
+    // Probes L1 then the STLB; an STLB hit is copied into L1. hit_level is
+    // set to 1 or 2 on a hit.
+    TLBEntry* lookup(uint16_t asid, u64 vpn, int& hit_level);
+    void insert(uint16_t asid, u64 vpn, u64 pfn, unsigned size_shift, bool dirty);
+    void invalidate(uint16_t asid, u64 vpn);
+    // Drops every translation of one address space.
+    void flush(uint16_t asid);
+    void flush();
+    void flush_walk_cache();
+    // Flushes everything and zeroes every statistic.
+    void reset();
+
+    // Accounts one page walk of a radix table with level_bits index bits
+    // per level that read entries down to stop_level (the leaf, or the
+    // first missing one); returns the memory references it made.
+    int walk(uint16_t asid, u64 vpn, int stop_level, unsigned level_bits);
+    void get_statistics() const;
+};
@@ -0,0 +1,276 @@
+#include "TLSFAllocator.h"
+#include <iostream>
+#include <iomanip>
+#include <climits>
+#include <string>
+
+static int msb_index(uint64_t x) { return 63 - __builtin_clzll(x); }
+static int lsb_index(uint64_t x) { return __builtin_ctzll(x); }
+
+TLSFAllocator::~TLSFAllocator() {
+    release_all();
+}
+
+void TLSFAllocator::release_all() {
+    nodes.reset();
+    head = nullptr;
+    allocated.clear();
+    fl_bitmap = 0;
+    free_bytes = free_blocks = internal_frag = 0;
+    std::fill(std::begin(free_histogram), std::end(free_histogram), 0);
+    for (int i = 0; i < FL_COUNT; i++) {
+        sl_bitmap[i] = 0;
+        for (int j = 0; j < SL_COUNT; j++) free_lists[i][j] = largest[i][j] = nullptr;
+    }
+}
+
+void TLSFAllocator::mapping_insert(size_t size, int& fl, int& sl) {
+    if (size < SMALL_BLOCK) {
+        fl = 0;
+        sl = static_cast<int>(size / (SMALL_BLOCK / SL_COUNT));
+    } else {
+        int msb = msb_index(size);
+        sl = static_cast<int>(size >> (msb - SL_LOG2)) ^ SL_COUNT;
+        fl = msb - (FL_SHIFT - 1);
+    }
+}
+
+// Rounds the request up to the next class boundary so that any block found
+// in the resulting class is guaranteed to fit.
+void TLSFAllocator::mapping_search(size_t size, int& fl, int& sl) {
+    if (size >= SMALL_BLOCK) size += (size_t(1) << (msb_index(size) - SL_LOG2)) - 1;
+    mapping_insert(size, fl, sl);
+}
+
+TLSFBlock* TLSFAllocator::find_suitable(int& fl, int& sl) {
+    uint32_t sl_map = sl_bitmap[fl] & (~0u << sl);
+    if (!sl_map) {
+        uint64_t fl_map = (fl + 1 < 64) ? fl_bitmap & (~uint64_t(0) << (fl + 1)) : 0;
+        if (!fl_map) return nullptr;
+        fl = lsb_index(fl_map);
+        sl_map = sl_bitmap[fl];
+    }
+    sl = lsb_index(sl_map);
+    return free_lists[fl][sl];
+}
+
+void TLSFAllocator::insert_free(TLSFBlock* blk) {
+    int fl, sl;
+    mapping_insert(blk->size, fl, sl);
+    blk->is_free = true;
+    blk->prev_free = nullptr;
+    blk->next_free = free_lists[fl][sl];
+    if (blk->next_free) blk->next_free->prev_free = blk;
+    free_lists[fl][sl] = blk;
+    if (!largest[fl][sl] || blk->size > largest[fl][sl]->size) largest[fl][sl] = blk;
+    fl_bitmap |= uint64_t(1) << fl;
+    sl_bitmap[fl] |= 1u << sl;
+    free_bytes += blk->size;
+    free_blocks++;
+    free_histogram[size_bucket(blk->size)]++;
+}
+
+void TLSFAllocator::remove_free(TLSFBlock* blk) {
+    int fl, sl;
+    mapping_insert(blk->size, fl, sl);
+    if (blk->prev_free) blk->prev_free->next_free = blk->next_free;
+    else free_lists[fl][sl] = blk->next_free;
+    if (blk->next_free) blk->next_free->prev_free = blk->prev_free;
+    blk->prev_free = blk->next_free = nullptr;
+    if (largest[fl][sl] == blk) {
+        largest[fl][sl] = free_lists[fl][sl];
+        for (TLSFBlock* b = free_lists[fl][sl]; b; b = b->next_free)
+            if (b->size > largest[fl][sl]->size) largest[fl][sl] = b;
+    }
+    free_bytes -= blk->size;
+    free_blocks--;
+    free_histogram[size_bucket(blk->size)]--;
+
+    if (!free_lists[fl][sl]) {
+        sl_bitmap[fl] &= ~(1u << sl);
+        if (!sl_bitmap[fl]) fl_bitmap &= ~(uint64_t(1) << fl);
+    }
+}
+
+void TLSFAllocator::init(size_t mem_size) {
+    release_all();
+    total_size = mem_size;
+    if (mem_size == 0) return;
+
+    head = nodes.create(size_t(0), mem_size);
+    insert_free(head);
+    if (announce) std::cout << "[System] TLSF Memory Initialized: " << mem_size << " bytes.\n";
+}
+
+int TLSFAllocator::allocate(size_t mem_size, Alloc_Algo) {
+    if (mem_size == 0) return -1;
+    total_alloc_attempts++;
+
+    size_t aligned_size = (mem_size + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1);
+    if (aligned_size < mem_size || aligned_size > total_size) return -1;
+
+    int fl, sl;
+    mapping_search(aligned_size, fl, sl);
+    if (fl >= FL_COUNT) return -1;
+    TLSFBlock* blk = find_suitable(fl, sl);
+    if (!blk) {
+        // The rounded class is empty; the head of the request's own class may
+        // still fit (e.g. allocating the whole heap). Checking it stays O(1).
+        mapping_insert(aligned_size, fl, sl);
+        blk = free_lists[fl][sl];
+        if (!blk || blk->size < aligned_size) return -1;
+    }
+    remove_free(blk);
+
+    if (blk->size - aligned_size >= ALIGN_SIZE) {
+        TLSFBlock* rest = nodes.create(blk->address + aligned_size, blk->size - aligned_size);
+        rest->prev_phys = blk;
+        rest->next_phys = blk->next_phys;
+        if (blk->next_phys) blk->next_phys->prev_phys = rest;
+        blk->next_phys = rest;
+        blk->size = aligned_size;
+        insert_free(rest);
+    }
+
+    blk->is_free = false;
+    blk->id = allocated.insert(blk);
+    blk->req_size = mem_size;
+    internal_frag += blk->size - mem_size;
+
+    successful_allocations++;
+    return blk->id;
+}
+
+void TLSFAllocator::deallocate(int id) {
+    TLSFBlock* blk;
+    if (!allocated.erase(id, &blk)) return;
+
+    internal_frag -= blk->size - blk->req_size;
+    blk->id = 0;
+    blk->req_size = 0;
+
+    // Coalesce with next block if it is free
+    TLSFBlock* next = blk->next_phys;
+    if (next && next->is_free) {
+        remove_free(next);
+        blk->size += next->size;
+        blk->next_phys = next->next_phys;
+        if (next->next_phys) next->next_phys->prev_phys = blk;
+        nodes.destroy(next);
+    }
+
+    // Coalesce with previous block if it is free
+    TLSFBlock* prev = blk->prev_phys;
+    if (prev && prev->is_free) {
+        remove_free(prev);
+        prev->size += blk->size;
+        prev->next_phys = blk->next_phys;
+        if (blk->next_phys) blk->next_phys->prev_phys = prev;
+        nodes.destroy(blk);
+        blk = prev;
+    }
+
+    insert_free(blk);
+}
+
+// Cuts blk down to `keep` bytes and frees the rest, merging it with a free successor.
+void TLSFAllocator::split_tail(TLSFBlock* blk, size_t keep) {
+    TLSFBlock* rest = nodes.create(blk->address + keep, blk->size - keep);
+    blk->size = keep;
+    rest->prev_phys = blk;
+    rest->next_phys = blk->next_phys;
+    if (blk->next_phys) blk->next_phys->prev_phys = rest;
+    blk->next_phys = rest;
+
+    TLSFBlock* next = rest->next_phys;
+    if (next && next->is_free) {
+        remove_free(next);
+        rest->size += next->size;
+        rest->next_phys = next->next_phys;
+        if (next->next_phys) next->next_phys->prev_phys = rest;
+        nodes.destroy(next);
+    }
+    insert_free(rest);
+}
+
+int TLSFAllocator::reallocate(int id, size_t new_size, Alloc_Algo algo) {
+    TLSFBlock** slot = allocated.find(id);
+    if (!slot || new_size == 0) return -1;
+    TLSFBlock* blk = *slot;
+
+    size_t aligned_size = (new_size + (ALIGN_SIZE - 1)) & ~(ALIGN_SIZE - 1);
+    TLSFBlock* next = blk->next_phys;
+    bool fits = aligned_size <= blk->size;
+    bool grows_into_next = !fits && next && next->is_free && blk->size + next->size >= aligned_size;
+
+    if (!fits && !grows_into_next) {
+        int new_id = allocate(new_size, algo);
+        if (new_id != -1) deallocate(id);
+        return new_id;
+    }
+
+    internal_frag -= blk->size - blk->req_size;
+    if (grows_into_next) {
+        remove_free(next);
+        blk->size += next->size;
+        blk->next_phys = next->next_phys;
+        if (next->next_phys) next->next_phys->prev_phys = blk;
+        nodes.destroy(next);
+    }
+    if (blk->size - aligned_size >= ALIGN_SIZE) split_tail(blk, aligned_size);
+    blk->req_size = new_size;
+    internal_frag += blk->size - new_size;
+    return id;
+}
+
+size_t TLSFAllocator::get_address(int id) {
+    TLSFBlock** blk = allocated.find(id);
+    if (!blk) return SIZE_MAX;
+    return (*blk)->address;
+}
+
+void TLSFAllocator::display() {
+    TLSFBlock* curr = head;
+    while (curr) {
+        std::cout << "[" << std::hex << std::uppercase << "0x" << std::setfill('0') << std::setw(4) << curr->address
+                  << " - 0x" << std::setw(4) << (curr->address + curr->size - 1) << "] "
+                  << std::dec << (curr->is_free ? "FREE" : "USED (id=" + std::to_string(curr->id) + ")")
+                  << "\n";
+        curr = curr->next_phys;
+    }
+}
+
+AllocatorStats TLSFAllocator::snapshot() {
+    AllocatorStats s;
+    s.total_size = total_size;
+    s.free = free_bytes;
+    s.used = head ? total_size - free_bytes : 0;
+    s.internal_frag = internal_frag;
+    s.free_blocks = free_blocks;
+    std::copy(std::begin(free_histogram), std::end(free_histogram), s.free_histogram);
+
+    // The largest free block is the largest of the highest non-empty class.
+    if (fl_bitmap) {
+        int fl = msb_index(fl_bitmap);
+        s.largest_free = largest[fl][msb_index(sl_bitmap[fl])]->size;
+    }
+    return s;
+}
+
+void TLSFAllocator::get_statistics() {
+    AllocatorStats s = snapshot();
+
+    double ext_frag_perc = (s.free > 0)
+        ? (double)(s.free - s.largest_free) / s.free * 100.0
+        : 0.0;
+    double utilization = total_size > 0 ? (double)s.used / total_size * 100.0 : 0;
+    double success_rate = total_alloc_attempts > 0 ? (double)successful_allocations / total_alloc_attempts * 100.0 : 0;
+
+    std::cout << "Total memory: " << total_size << "\n";
+    std::cout << "Used memory: " << s.used << "\n";
+    std::cout << "Internal fragmentation: " << s.internal_frag << "\n";
+    std::cout << "External fragmentation: " << std::fixed << std::setprecision(0) << ext_frag_perc << "%\n";
+    std::cout << "Allocation success rate: " << success_rate << "%\n";
+    std::cout << "Memory utilization: " << utilization << "%\n";
+    print_free_histogram(s);
+}
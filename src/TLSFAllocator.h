@@ -0,0 +1,73 @@
+#pragma once
+#include <cstdint>
+#include "Allocator.h"
+#include "NodePool.h"
+#include "HandleTable.h"
+
+struct TLSFBlock {
+    int id;
+    size_t address;
+    size_t size;
+    size_t req_size;
+    bool is_free;
+    TLSFBlock* prev_phys;   // physical neighbours, in address order
+    TLSFBlock* next_phys;
+    TLSFBlock* prev_free;   // segregated free list links
+    TLSFBlock* next_free;
+
+    TLSFBlock(size_t addr, size_t s)
+        : id(0), address(addr), size(s), req_size(0), is_free(true),
+          prev_phys(nullptr), next_phys(nullptr), prev_free(nullptr), next_free(nullptr) {}
+};
+
+// Two-Level Segregated Fit: the first level splits sizes by power of two,
+// the second splits each power-of-two range linearly into SL_COUNT classes.
+// Two bitmaps give the first non-empty class with two bit scans, so allocate
+// and deallocate are O(1) regardless of heap size.
+class TLSFAllocator : public Allocator {
+private:
+    static constexpr int ALIGN_LOG2 = 3;
+    static constexpr size_t ALIGN_SIZE = size_t(1) << ALIGN_LOG2;
+    static constexpr int SL_LOG2 = 4;
+    static constexpr int SL_COUNT = 1 << SL_LOG2;
+    static constexpr int FL_SHIFT = SL_LOG2 + ALIGN_LOG2;
+    static constexpr size_t SMALL_BLOCK = size_t(1) << FL_SHIFT;
+    static constexpr int FL_COUNT = 64 - FL_SHIFT + 1;
+
+    size_t total_size = 0;
+    TLSFBlock* head = nullptr;   // lowest-address block
+    NodePool<TLSFBlock> nodes;
+    uint64_t fl_bitmap = 0;
+    uint32_t sl_bitmap[FL_COUNT] = {};
+    TLSFBlock* free_lists[FL_COUNT][SL_COUNT] = {};
+    // Largest block in each list, so snapshot() reads the largest free block
+    // straight from the top class. Only removing that block rescans its list.
+    TLSFBlock* largest[FL_COUNT][SL_COUNT] = {};
+    HandleTable<TLSFBlock*> allocated;
+    size_t free_bytes = 0, free_blocks = 0, internal_frag = 0;
+    size_t free_histogram[64] = {};
+    size_t total_alloc_attempts = 0;
+    size_t successful_allocations = 0;
+
+    static void mapping_insert(size_t size, int& fl, int& sl);
+    static void mapping_search(size_t size, int& fl, int& sl);
+    TLSFBlock* find_suitable(int& fl, int& sl);
+    void insert_free(TLSFBlock* blk);
+    void remove_free(TLSFBlock* blk);
+    void split_tail(TLSFBlock* blk, size_t keep);
+    void release_all();
+
+public:
+    TLSFAllocator() = default;
+    ~TLSFAllocator();
+    void init(size_t mem_size) override;
+    std::unique_ptr<Allocator> make_empty() const override { return std::make_unique<TLSFAllocator>(); }
+    int next_block_id() override { return allocated.next_id(); }
+    int allocate(size_t mem_size, Alloc_Algo algo = Firstfit) override;
+    void deallocate(int id) override;
+    size_t get_address(int id) override;
+    void display() override;
+    void get_statistics() override;
+    AllocatorStats snapshot() override;
+    int reallocate(int id, size_t new_size, Alloc_Algo algo = Firstfit) override;
+};
@@ -1,103 +1,370 @@
 #include "VirtualMemory.h"
 #include <iostream>
 #include <iomanip>
-#include <limits>
+#include <algorithm>
+#include <stdexcept>
 
-TLB::TLB(int num_entries, int assoc) : ways(assoc) {
-    sets = num_entries / ways;
-    table.resize(sets, std::vector<TLBEntry>(ways));
+static bool is_pow2(u64 v) { return v && !(v & (v - 1)); }
+static unsigned log2_of(u64 v) { return 63 - __builtin_clzll(v); }
+
+VirtualMemory::VirtualMemory(MemoryHierarchy* cache, PageReplacementAlgo p, u64 page, u64 virt, u64 phys)
+    : policy(p), cache_ptr(cache) {
+    configure(page, virt, phys);
 }
 
-int TLB::lookup(u64 vpn) {
-    timer++;
-    int idx = vpn % sets;
-    for (auto& entry : table[idx]) {
-        if (entry.valid && entry.vpn == vpn) {
-            entry.last_access = timer;
-            return (int)entry.pfn;
-        }
-    }
-    return -1;
+void VirtualMemory::configure(u64 page, u64 virt, u64 phys) {
+    if (!is_pow2(page)) throw std::invalid_argument("Page size must be power of 2");
+    if (!is_pow2(virt) || virt < page || virt > (1ULL << 63))
+        throw std::invalid_argument("Virtual size must be a power of 2 from one page to 2^63");
+    if (phys < page || phys % page != 0 || phys / page > (1ULL << 24))
+        throw std::invalid_argument("Physical size must be 1 to 2^24 whole pages");
+
+    page_size = page;
+    virtual_size = virt;
+    physical_size = phys;
+    page_bits = log2_of(page);
+    processes.clear();
+    processes.emplace_back(0, 0, log2_of(virt) - page_bits);
+    current = 0;
+    total_frames = phys / page;
+    frame_table.assign(total_frames, NO_PAGE);
+    frame_refs.assign(total_frames, 0);
+    free_frames.clear();
+    for (u64 f = total_frames; f-- > 0;) free_frames.push_back(static_cast<int>(f));
+    lru_order.reset(total_frames);
+    fifo_order.reset(total_frames);
+    referenced.assign((total_frames + 63) / 64, 0);
+    pinned.assign((total_frames + 63) / 64, 0);
+    pinned_frames = huge_pages = 0;
+    page_faults = page_hits = disk_accesses = 0;
+    clock_hand = 0;
+    if (swap_ptr) swap_ptr->reset(page);
 }
 
-void TLB::insert(u64 vpn, u64 pfn) {
-    int idx = vpn % sets;
-    int victim = 0; u64 min_t = std::numeric_limits<u64>::max();
-    for (int i = 0; i < ways; i++) {
-        if (!table[idx][i].valid) { victim = i; break; }
-        if (table[idx][i].last_access < min_t) { min_t = table[idx][i].last_access; victim = i; }
-    }
-    table[idx][victim] = {true, vpn, pfn, timer};
+void VirtualMemory::FrameList::push_back(int f) {
+    links[f] = {tail, -1};
+    if (tail != -1) links[tail].next = f; else head = f;
+    tail = f;
 }
 
-VirtualMemory::VirtualMemory(MemoryHierarchy* cache, PageReplacementAlgo p) 
-    : policy(p), cache_ptr(cache) {
-    total_frames = PHYSICAL_MEM_SIZE / PAGE_SIZE;
-    page_table.resize(VIRTUAL_MEM_SIZE / PAGE_SIZE);
-    frame_table.assign(total_frames, -1);
+void VirtualMemory::FrameList::remove(int f) {
+    Link& l = links[f];
+    if (l.prev != -1) links[l.prev].next = l.next; else head = l.next;
+    if (l.next != -1) links[l.next].prev = l.prev; else tail = l.prev;
 }
 
 void VirtualMemory::set_replacement_policy(PageReplacementAlgo p) {
     policy = p;
 }
 
+void VirtualMemory::set_swap_device(SwapDevice* swap) {
+    swap_ptr = swap;
+    for (Process& p : processes) p.swap_slots.clear();
+    if (swap_ptr) swap_ptr->reset(page_size);
+}
+
 int VirtualMemory::find_free_frame() {
-    for (int i = 0; i < (int)total_frames; i++) if (frame_table[i] == -1) return i;
-    return -1;
-}
-
-int VirtualMemory::evict_page() {
-    int v_f = -1, v_p = -1;
-    if (policy == VM_LRU || policy == VM_FIFO) {
-        u64 min_t = std::numeric_limits<u64>::max();
-        for (int i = 0; i < (int)total_frames; i++) {
-            int p_idx = frame_table[i];
-            u64 t = (policy == VM_LRU) ? page_table[p_idx].last_access_time : page_table[p_idx].loaded_time;
-            if (t < min_t) { min_t = t; v_f = i; v_p = p_idx; }
-        }
-    } else {
-        while (true) {
-            int p_idx = frame_table[clock_hand];
-            if (page_table[p_idx].referenced) {
-                page_table[p_idx].referenced = false;
-                clock_hand = (clock_hand + 1) % total_frames;
-            } else { v_f = clock_hand; v_p = p_idx; clock_hand = (clock_hand + 1) % total_frames; break; }
+    if (free_frames.empty()) return -1;
+    int f = free_frames.back();
+    free_frames.pop_back();
+    return f;
+}
+
+// Sweeps from the hand, clearing reference bits, to the first unreferenced
+// frame, and leaves the hand just past it.
+int VirtualMemory::clock_victim() {
+    while (true) {
+        size_t w = clock_hand >> 6;
+        unsigned from = clock_hand & 63;
+        u64 limit = std::min<u64>(64, total_frames - w * 64);
+        u64 span = (limit == 64 ? ~0ULL : (1ULL << limit) - 1) & (~0ULL << from);
+        u64 unreferenced = ~(referenced[w] | pinned[w]) & span;
+        if (unreferenced) {
+            unsigned v = __builtin_ctzll(unreferenced);
+            referenced[w] &= ~(span & ((1ULL << v) - 1));
+            int victim = static_cast<int>(w * 64 + v);
+            clock_hand = (victim + 1) % total_frames;
+            return victim;
         }
+        referenced[w] &= ~span;
+        clock_hand = (w * 64 + limit) % total_frames;
     }
-    
+}
+
+// Evicts the page resident in frame f from every page table mapping it:
+// drops its cache lines and TLB entries and writes it back once if any
+// mapper dirtied it. Returns whether it was dirty.
+bool VirtualMemory::release_frame(int f, TLB& tlb) {
+    lru_order.remove(f);
+    fifo_order.remove(f);
+    u64 vpn = frame_table[f];
     if (cache_ptr) {
-        u64 physical_addr = (u64)v_f * PAGE_SIZE;
-        cache_ptr->invalidate_physical_range(physical_addr, PAGE_SIZE);
+        u64 physical_addr = (u64)f << page_bits;
+        cache_ptr->invalidate_physical_range(physical_addr, page_size);
     }
 
-    if (page_table[v_p].dirty) disk_accesses++;
-    page_table[v_p].valid = false;
-    frame_table[v_f] = -1;
+    bool dirty = false;
+    uint32_t mappers = frame_refs[f];
+    evicted_from.clear();
+    for (size_t i = 0; i < processes.size() && mappers > 0; i++) {
+        Process& p = processes[i];
+        int level = 0;
+        PageTableEntry* pte = p.table.find(vpn, &level);
+        if (!pte || !pte->valid || pte->frame_number != f || p.table.page_shift_at(level) != 0) continue;
+        dirty |= pte->dirty;
+        pte->valid = false;
+        p.rss--;
+        tlb.invalidate(p.asid, vpn);
+        evicted_from.push_back(i);
+        mappers--;
+    }
+    if (dirty) disk_accesses++;
+    if (dirty && swap_ptr) swap_out(vpn);
+    frame_table[f] = NO_PAGE;
+    frame_refs[f] = 0;
+    return dirty;
+}
+
+// Writes the dirty page at vpn, just unmapped from the processes in
+// evicted_from, to a slot they all point at. The slot they share is
+// rewritten in place when nobody else holds it; otherwise they move to a
+// fresh one.
+void VirtualMemory::swap_out(u64 vpn) {
+    auto slot_of = [&](size_t i) {
+        auto it = processes[i].swap_slots.find(vpn);
+        return it == processes[i].swap_slots.end() ? SwapDevice::NO_SLOT : it->second;
+    };
+    u64 slot = slot_of(evicted_from[0]);
+    bool in_place = slot != SwapDevice::NO_SLOT && swap_ptr->refs(slot) == evicted_from.size();
+    for (size_t i : evicted_from) in_place = in_place && slot_of(i) == slot;
+    if (!in_place) {
+        slot = swap_ptr->allocate();
+        for (size_t n = 0; n < evicted_from.size(); n++) {
+            std::unordered_map<u64, u64>& slots = processes[evicted_from[n]].swap_slots;
+            auto it = slots.find(vpn);
+            if (it != slots.end()) swap_ptr->release(it->second);
+            if (slot == SwapDevice::NO_SLOT) {
+                if (it != slots.end()) slots.erase(it);
+                continue;
+            }
+            slots[vpn] = slot;
+            if (n > 0) swap_ptr->retain(slot);
+        }
+    }
+    if (slot != SwapDevice::NO_SLOT) swap_ptr->write(slot, vpn);
+}
+
+// Reads p's swapped copy of vpn back; a page never swapped out is zero-filled.
+void VirtualMemory::swap_in(const Process& p, u64 vpn) {
+    auto it = p.swap_slots.find(vpn);
+    if (it != p.swap_slots.end()) swap_ptr->read(it->second);
+}
+
+// Makes frame f, already mapped to vpn by the caller, a resident private
+// page of the current process.
+void VirtualMemory::load_frame(int f, u64 vpn) {
+    frame_table[f] = vpn;
+    frame_refs[f] = 1;
+    processes[current].rss++;
+    lru_order.push_back(f);
+    fifo_order.push_back(f);
+    referenced[f >> 6] |= 1ULL << (f & 63);
+}
+
+// Handles a write by the current process to the shared page at vpn. The last
+// mapper left takes the frame over; otherwise the page is copied to a free or
+// evicted frame, and read back from disk first if that eviction took the
+// original. Returns whether a copy was made.
+bool VirtualMemory::copy_on_write(u64 vpn, PageTableEntry* pte, bool& writeback, TLB& tlb) {
+    Process& p = processes[current];
+    int shared = pte->frame_number;
+    if (frame_refs[shared] == 1) {
+        pte->cow = false;
+        return false;
+    }
+    int f = find_free_frame();
+    if (f == -1) f = evict_page(writeback, tlb);
+    if (pte->valid) {
+        frame_refs[shared]--;
+        p.rss--;
+    } else {
+        disk_accesses++;
+        if (swap_ptr) swap_in(p, vpn);
+    }
+    *pte = {true, true, false, f};
+    load_frame(f, vpn);
+    p.cow_faults++;
+    tlb.invalidate(p.asid, vpn);
+    tlb.insert(p.asid, vpn, f, 0, true);
+    return true;
+}
+
+int VirtualMemory::evict_page(bool& dirty, TLB& tlb) {
+    int v_f;
+    if (policy == VM_LRU) v_f = lru_order.head;
+    else if (policy == VM_FIFO) v_f = fifo_order.head;
+    else v_f = clock_victim();
+    dirty = release_frame(v_f, tlb);
     return v_f;
 }
 
-ll VirtualMemory::translate(u64 v_addr, bool is_write, TLB& tlb, std::string& report) {
-    access_counter++;
-    u64 vpn = v_addr / PAGE_SIZE, offset = v_addr % PAGE_SIZE;
-    int pfn = tlb.lookup(vpn);
-    if (pfn != -1) { report = "TLB Hit"; page_hits++; return (ll)(pfn * PAGE_SIZE + offset); }
-    if (page_table[vpn].valid) {
-        report = "Page Table Hit"; page_hits++;
-        page_table[vpn].last_access_time = access_counter;
-        page_table[vpn].referenced = true;
-        if (is_write) page_table[vpn].dirty = true;
-        tlb.insert(vpn, page_table[vpn].frame_number);
-        return (ll)(page_table[vpn].frame_number * PAGE_SIZE + offset);
+Translation VirtualMemory::translate(u64 v_addr, bool is_write, TLB& tlb) {
+    if (v_addr >= virtual_size) return {-1, VM_INVALID_ADDRESS, false, 0};
+    Process& p = processes[current];
+    u64 vpn = v_addr >> page_bits, offset = v_addr & (page_size - 1);
+    bool writeback = false;
+    if (swap_ptr) swap_ptr->tick();
+    u64 start = swap_ptr ? swap_ptr->get_time() : 0;
+
+    int tlb_level = 0;
+    if (TLBEntry* e = tlb.lookup(p.asid, vpn, tlb_level)) {
+        // The first write through a clean entry sets the dirty bit in the PTE;
+        // entries of shared pages stay clean so that write can copy them.
+        if (is_write && !e->dirty) {
+            PageTableEntry* pte = p.table.find(vpn);
+            if (pte->cow && copy_on_write(vpn, pte, writeback, tlb)) {
+                finish_fault(start);
+                return {(ll)(((u64)pte->frame_number << page_bits) + offset), VM_COW_FAULT, writeback, 0};
+            }
+            pte->dirty = true;
+            e->dirty = true;
+        }
+        page_hits++;
+        u64 pfn = e->pfn + (vpn & ((1ULL << e->size_shift) - 1));
+        return {(ll)((pfn << page_bits) + offset), tlb_level == 1 ? VM_TLB_HIT : VM_STLB_HIT, false, 0};
+    }
+
+    int level = 0;
+    PageTableEntry* pte = p.table.find(vpn, &level);
+    uint8_t refs = static_cast<uint8_t>(tlb.walk(p.asid, vpn, p.table.is_flat() ? 0 : level, p.table.get_level_bits()));
+    if (pte && pte->valid) {
+        if (is_write && pte->cow && copy_on_write(vpn, pte, writeback, tlb)) {
+            finish_fault(start);
+            return {(ll)(((u64)pte->frame_number << page_bits) + offset), VM_COW_FAULT, writeback, refs};
+        }
+        page_hits++;
+        unsigned shift = p.table.page_shift_at(level);
+        if (shift == 0) {   // huge pages are pinned and need no replacement state
+            int f = pte->frame_number;
+            lru_order.remove(f);
+            lru_order.push_back(f);
+            referenced[f >> 6] |= 1ULL << (f & 63);
+        }
+        if (is_write) pte->dirty = true;
+        tlb.insert(p.asid, vpn, pte->frame_number, shift, pte->dirty && !pte->cow);
+        u64 pfn = pte->frame_number + (vpn & ((1ULL << shift) - 1));
+        return {(ll)((pfn << page_bits) + offset), VM_PAGE_TABLE_HIT, false, refs};
     }
-    report = "Page Fault"; page_faults++; disk_accesses++;
+    page_faults++; disk_accesses++;
+    p.faults++;
     int f = find_free_frame();
-    if (f == -1) f = evict_page();
-    page_table[vpn] = {true, is_write, true, f, access_counter, access_counter};
-    frame_table[f] = (int)vpn;
-    tlb.insert(vpn, f);
-    return (ll)(f * PAGE_SIZE + offset);
+    if (f == -1) f = evict_page(writeback, tlb);
+    if (swap_ptr) swap_in(p, vpn);
+    p.table.map(vpn) = {true, is_write, false, f};
+    load_frame(f, vpn);
+    tlb.insert(p.asid, vpn, f, 0, is_write);
+    finish_fault(start);
+    return {(ll)(((u64)f << page_bits) + offset), VM_PAGE_FAULT, writeback, refs};
+}
+
+void VirtualMemory::map_huge(u64 v_addr, u64 size, TLB& tlb) {
+    PageTable& page_table = processes[current].table;
+    int level = 0;
+    for (int L = 1; L <= PageTable::LEVELS - 2 && !page_table.is_flat(); L++)
+        if (size == page_size << page_table.page_shift_at(L)) level = L;
+    if (level == 0) throw std::invalid_argument("Unsupported huge page size for this address space");
+    if (v_addr % size != 0 || v_addr >= virtual_size) throw std::invalid_argument("Huge page must be aligned and inside the virtual space");
+
+    PageTableEntry* existing = page_table.find(v_addr >> page_bits);
+    if (existing && existing->valid) throw std::invalid_argument("Range is already mapped");
+
+    // Take the unpinned aligned run with the fewest resident pages.
+    u64 run = size / page_size;
+    u64 start = total_frames, fewest = run + 1;
+    if (pinned_frames + run < total_frames) {
+        for (u64 r = 0; r + run <= total_frames && fewest > 0; r += run) {
+            u64 resident = 0;
+            bool clear = true;
+            for (u64 f = r; f < r + run && clear; f++) {
+                clear = !(pinned[f >> 6] >> (f & 63) & 1);
+                if (frame_table[f] != NO_PAGE) resident++;
+            }
+            if (clear && resident < fewest) { start = r; fewest = resident; }
+        }
+    }
+    if (start == total_frames) throw std::invalid_argument("No free aligned frame run for the huge page");
+
+    page_table.map_huge(v_addr >> page_bits, level, static_cast<int>(start));
+    tlb.flush_walk_cache();   // a released subtree may still be cached
+    for (u64 f = start; f < start + run; f++) {
+        if (frame_table[f] != NO_PAGE) release_frame(static_cast<int>(f), tlb);
+        frame_refs[f] = 1;
+        pinned[f >> 6] |= 1ULL << (f & 63);
+    }
+    processes[current].rss += run;
+    free_frames.erase(std::remove_if(free_frames.begin(), free_frames.end(),
+                                     [&](int f) { return (u64)f >= start && (u64)f < start + run; }),
+                      free_frames.end());
+    pinned_frames += run;
+    huge_pages++;
+}
+
+void VirtualMemory::fork(int child_pid, TLB& tlb) {
+    for (const Process& p : processes)
+        if (p.pid == child_pid) throw std::invalid_argument("Process " + std::to_string(child_pid) + " already exists");
+    if (processes.size() > UINT16_MAX) throw std::invalid_argument("At most 65536 processes are supported");
+
+    processes.emplace_back(child_pid, static_cast<uint16_t>(processes.size()), log2_of(virtual_size) - page_bits);
+    Process& parent = processes[current];
+    Process& child = processes.back();
+    child.swap_slots = parent.swap_slots;
+    for (const auto& entry : child.swap_slots) swap_ptr->retain(entry.second);
+    parent.table.for_each_mapping([&](u64 vpn, int level, PageTableEntry& pte) {
+        unsigned shift = parent.table.page_shift_at(level);
+        if (shift == 0) {
+            pte.cow = true;
+            child.table.map(vpn) = pte;
+            frame_refs[pte.frame_number]++;
+            child.rss++;
+            return;
+        }
+        child.table.map_huge(vpn, level, pte.frame_number);
+        for (u64 f = pte.frame_number; f < pte.frame_number + (1ULL << shift); f++) frame_refs[f]++;
+        child.rss += 1ULL << shift;
+    });
+    tlb.flush(parent.asid);
+}
+
+void VirtualMemory::switch_to(int pid) {
+    for (size_t i = 0; i < processes.size(); i++) {
+        if (processes[i].pid == pid) {
+            current = i;
+            return;
+        }
+    }
+    throw std::invalid_argument("No process " + std::to_string(pid));
 }
 
 void VirtualMemory::get_statistics() {
+    const PageTable& page_table = processes[current].table;
     std::cout << "VM: Hits=" << page_hits << ", Faults=" << page_faults << ", Disk=" << disk_accesses << "\n";
-}
\ No newline at end of file
+    if (!page_table.is_flat())
+        std::cout << "Page table: " << PageTable::LEVELS << "-level radix, " << page_table.node_count()
+                  << " nodes, " << page_table.bytes() << " bytes\n";
+    if (huge_pages)
+        std::cout << "Huge pages: " << huge_pages << " (" << pinned_frames << " frames pinned)\n";
+    if (processes.size() > 1) {
+        // Sharing saves whatever the resident sets hold beyond the frames in use.
+        u64 mapped = 0, shared = 0;
+        for (size_t i = 0; i < processes.size(); i++) {
+            const Process& p = processes[i];
+            std::cout << "Process " << p.pid << (i == current ? " (current)" : "") << ": ASID=" << p.asid
+                      << ", RSS=" << p.rss << " pages (" << p.rss * page_size << " bytes), Faults=" << p.faults
+                      << ", COW faults=" << p.cow_faults << "\n";
+            mapped += p.rss;
+        }
+        for (uint32_t refs : frame_refs) if (refs > 1) shared++;
+        u64 in_use = total_frames - free_frames.size();
+        std::cout << "Shared frames=" << shared << " | Memory saved by sharing=" << (mapped - in_use) * page_size << " bytes\n";
+    }
+}
@@ -1,56 +1,133 @@
 #include <vector>
 #include <string>
 #include <cstdint>
+#include <unordered_map>
 #include "Cache.h"
+#include "PageTable.h"
+#include "SwapDevice.h"
+#include "TLB.h"
 
 using ll = long long;
 using u64 = uint64_t;
 
-const u64 PAGE_SIZE = 64;
-const u64 VIRTUAL_MEM_SIZE = 4096;
-const u64 PHYSICAL_MEM_SIZE = 1024;
+// Defaults; 'init vm' replaces them at runtime.
+const u64 DEFAULT_PAGE_SIZE = 64;
+const u64 DEFAULT_VIRTUAL_MEM_SIZE = 4096;
+const u64 DEFAULT_PHYSICAL_MEM_SIZE = 1024;
 
 enum PageReplacementAlgo { VM_FIFO, VM_LRU, VM_CLOCK };
 
-struct TLBEntry {
-    bool valid = false;
-    u64 vpn = 0, pfn = 0, last_access = 0;
-};
+// Where a translation was resolved. VM_COW_FAULT is a write to a page still
+// shared since a fork, which copied it to a private frame. VM_INVALID_ADDRESS
+// is an address past the end of the virtual space; its physical_addr is -1.
+enum TranslationSource { VM_TLB_HIT, VM_STLB_HIT, VM_PAGE_TABLE_HIT, VM_PAGE_FAULT, VM_COW_FAULT, VM_INVALID_ADDRESS };
 
-class TLB {
-public:
-    int sets, ways; u64 timer = 0;
-    std::vector<std::vector<TLBEntry>> table;
-    TLB(int num_entries, int assoc);
-    int lookup(u64 vpn);
-    void insert(u64 vpn, u64 pfn);
+struct Translation {
+    ll physical_addr;
+    TranslationSource source;
+    bool writeback;     // the fault evicted a dirty page to disk
+    uint8_t walk_refs;  // page-table memory references, 0 on a TLB hit
 };
 
-struct PageTableEntry {
-    bool valid = false, dirty = false, referenced = false;
-    int frame_number = -1;
-    u64 last_access_time = 0, loaded_time = 0;
-};
-
-
+// Processes have their own page tables and TLB tags (the ASID is the
+// process's slot) over one pool of frames. A fork shares every base page of
+// the parent copy-on-write and huge pages outright; a frame counts the page
+// tables mapping it, and since a fork copies the layout they all map it at
+// the same vpn, so eviction finds every mapper by looking up that vpn.
 class VirtualMemory {
 private:
-    std::vector<PageTableEntry> page_table;
-    std::vector<int> frame_table;
-    u64 total_frames, access_counter = 0;
+    static constexpr u64 NO_PAGE = ~0ULL;
+
+    struct Process {
+        int pid;
+        uint16_t asid;
+        PageTable table;
+        u64 rss = 0, faults = 0, cow_faults = 0;   // rss in base pages
+        std::unordered_map<u64, u64> swap_slots;    // vpn -> slot holding its copy
+
+        Process(int id, uint16_t a, unsigned vpn_bits) : pid(id), asid(a), table(vpn_bits) {}
+    };
+
+    // Doubly linked list of frames threaded through per-frame links.
+    struct FrameList {
+        struct Link { int prev = -1, next = -1; };
+        std::vector<Link> links;
+        int head = -1, tail = -1;
+
+        void reset(size_t frames) { links.assign(frames, Link()); head = tail = -1; }
+        void push_back(int f);
+        void remove(int f);
+    };
+
+    u64 page_size, virtual_size, physical_size;
+    unsigned page_bits;
+    std::vector<Process> processes;
+    size_t current = 0;
+    std::vector<u64> frame_table;     // resident vpn per frame, or NO_PAGE
+    std::vector<uint32_t> frame_refs; // page tables mapping each frame
+    // Victim bookkeeping, all O(1) per fault: free frames are a stack (lowest
+    // number on top), resident frames sit on both an LRU list (touched on
+    // page-table hits) and a FIFO queue (load order) so the policy can switch
+    // at any time, and CLOCK reference bits are packed 64 to a word so the
+    // hand clears and skips a run of referenced frames a word at a time.
+    std::vector<int> free_frames;
+    FrameList lru_order, fifo_order;
+    std::vector<u64> referenced;
+    std::vector<u64> pinned;          // frames backing huge pages, never victims
+    u64 total_frames, pinned_frames = 0, huge_pages = 0;
     u64 page_faults = 0, page_hits = 0, disk_accesses = 0;
     
     PageReplacementAlgo policy;
     int clock_hand = 0;
     MemoryHierarchy* cache_ptr; 
+    SwapDevice* swap_ptr = nullptr;
+    std::vector<size_t> evicted_from;   // scratch: processes losing a frame
 
     int find_free_frame();
-    int evict_page();
+    int clock_victim();
+    int evict_page(bool& dirty, TLB& tlb);
+    bool release_frame(int f, TLB& tlb);
+    void load_frame(int f, u64 vpn);
+    void swap_out(u64 vpn);
+    void swap_in(const Process& p, u64 vpn);
+    void finish_fault(u64 start) { if (swap_ptr) swap_ptr->record_fault(swap_ptr->get_time() - start); }
+    bool copy_on_write(u64 vpn, PageTableEntry* pte, bool& writeback, TLB& tlb);
 
 public:
-    VirtualMemory(MemoryHierarchy* cache, PageReplacementAlgo p = VM_LRU);
+    // Throws std::invalid_argument unless page and virtual sizes are powers
+    // of 2 with at least one page of virtual space, at most 2^63 bytes of it,
+    // and physical memory is a whole number of pages (1 to 2^24 frames).
+    VirtualMemory(MemoryHierarchy* cache, PageReplacementAlgo p = VM_LRU, u64 page = DEFAULT_PAGE_SIZE,
+                  u64 virt = DEFAULT_VIRTUAL_MEM_SIZE, u64 phys = DEFAULT_PHYSICAL_MEM_SIZE);
+    // Replaces the geometry, dropping every mapping and statistic; on a bad
+    // geometry it throws as the constructor does and leaves the old one.
+    void configure(u64 page, u64 virt, u64 phys);
+    u64 get_page_size() const { return page_size; }
+    u64 get_virtual_size() const { return virtual_size; }
+    u64 get_physical_size() const { return physical_size; }
+    const PageTable& get_page_table() const { return processes[current].table; }
+    int current_pid() const { return processes[current].pid; }
     void set_replacement_policy(PageReplacementAlgo p);
-    ll translate(u64 v_addr, bool is_write, TLB& tlb, std::string& report);
+    // Pages dirty when evicted are written to swap, and faults read them back
+    // from it, timing both; nullptr detaches it. Every process's swap slots
+    // are forgotten and the device is reset to the current page size.
+    void set_swap_device(SwapDevice* swap);
+    Translation translate(u64 v_addr, bool is_write, TLB& tlb);
+    // Maps the huge page of `size` bytes at v_addr onto an aligned run of
+    // frames, evicting whatever is resident there; huge pages stay pinned.
+    // Sizes are those of the page table's upper-level leaves (2MB and 1GB
+    // for 4KB pages in a 48-bit space). Throws std::invalid_argument for an
+    // unsupported size, a misaligned or mapped range, or when no run is left
+    // that keeps one frame pageable.
+    void map_huge(u64 v_addr, u64 size, TLB& tlb);
+    // Creates process child_pid as a copy of the current one, sharing its
+    // resident pages; the parent's translations are flushed so its next
+    // write to a shared page faults. Throws std::invalid_argument for a pid
+    // in use or past 65536 processes.
+    void fork(int child_pid, TLB& tlb);
+    // Makes pid the current process; ASID tags keep its TLB entries apart,
+    // so nothing is flushed. Throws std::invalid_argument for an unknown pid.
+    void switch_to(int pid);
     void get_statistics();
 };
 